@@ -0,0 +1,74 @@
+/*
+ *  BinaryLog.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  A RAM ring buffer of binary log records
+ */
+
+#include "BinaryLog.h"
+#include "Arduino.h"
+
+void BinaryLog::Write(PIBLogMessage_t id, const uint8_t * args, uint8_t arg_length)
+{
+    uint16_t record_size = BINARY_LOG_HEADER_SIZE + arg_length;
+    uint32_t timestamp = millis();
+
+    // make room by overwriting the oldest records
+    while (BINARY_LOG_SIZE - count < record_size) {
+        DropOldest();
+    }
+
+    Push(id);
+    Push(arg_length);
+    for (int i = 0; i < 4; i++) {
+        Push((uint8_t) (timestamp >> (8 * i)));
+    }
+    for (int i = 0; i < arg_length; i++) {
+        Push(args[i]);
+    }
+}
+
+uint16_t BinaryLog::Drain(uint8_t * buffer, uint16_t buffer_size)
+{
+    uint16_t copied = 0;
+    uint16_t record_size = 0;
+
+    while (count >= BINARY_LOG_HEADER_SIZE) {
+        record_size = BINARY_LOG_HEADER_SIZE + Peek(1);
+        if (copied + record_size > buffer_size) break;
+
+        for (int i = 0; i < record_size; i++) {
+            buffer[copied++] = ring[tail];
+            tail = (tail + 1) % BINARY_LOG_SIZE;
+            count--;
+        }
+    }
+
+    dropped = 0;
+
+    return copied;
+}
+
+void BinaryLog::DropOldest()
+{
+    uint16_t record_size = BINARY_LOG_HEADER_SIZE + Peek(1);
+
+    if (record_size > count) record_size = count; // shouldn't happen, but never underflow
+
+    tail = (tail + record_size) % BINARY_LOG_SIZE;
+    count -= record_size;
+    dropped++;
+}
+
+void BinaryLog::Push(uint8_t byte)
+{
+    ring[head] = byte;
+    head = (head + 1) % BINARY_LOG_SIZE;
+    count++;
+}
+
+uint8_t BinaryLog::Peek(uint16_t offset)
+{
+    return ring[(tail + offset) % BINARY_LOG_SIZE];
+}
@@ -0,0 +1,80 @@
+/*
+ *  BinaryLog.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  A RAM ring buffer of binary log records. Each call site logs a static
+ *  message id from PIBLogMessages.h and its raw arguments; the text is only
+ *  rebuilt on the ground (see BinaryLogDecoder.h), so no formatting happens
+ *  on the PIB.
+ *
+ *  Record format (little-endian):
+ *    [message id (1)][argument length (1)][millis (4)][arguments]
+ *
+ *  Arguments are packed with their native size, so each argument must be cast
+ *  to the type declared for the message in PIBLogMessages.h.
+ */
+
+#ifndef BINARYLOG_H
+#define BINARYLOG_H
+
+#include "PIBLogMessages.h"
+#include <stdint.h>
+#include <string.h>
+
+#define BINARY_LOG_SIZE         2048
+#define BINARY_LOG_HEADER_SIZE  6
+#define BINARY_LOG_MAX_ARGS     32
+
+class BinaryLog {
+public:
+    BinaryLog() { };
+    ~BinaryLog() { };
+
+    template <typename... Args>
+    void Log(PIBLogMessage_t id, Args... args)
+    {
+        uint8_t arg_buffer[BINARY_LOG_MAX_ARGS];
+        uint8_t arg_length = 0;
+
+        Pack(arg_buffer, &arg_length, args...);
+        Write(id, arg_buffer, arg_length);
+    }
+
+    // move as many whole records as fit into buffer, returns the number of bytes copied
+    uint16_t Drain(uint8_t * buffer, uint16_t buffer_size);
+
+    uint16_t BytesUsed() { return count; }
+
+    // number of records overwritten since the last drain
+    uint16_t Dropped() { return dropped; }
+
+private:
+    void Write(PIBLogMessage_t id, const uint8_t * args, uint8_t arg_length);
+    void DropOldest();
+    void Push(uint8_t byte);
+    uint8_t Peek(uint16_t offset);
+
+    static void Pack(uint8_t * buffer, uint8_t * length) { }
+
+    template <typename T, typename... Args>
+    static void Pack(uint8_t * buffer, uint8_t * length, T value, Args... args)
+    {
+        static_assert(sizeof(T) <= 4, "Binary log arguments must be 4 bytes or less");
+
+        if (*length + sizeof(T) <= BINARY_LOG_MAX_ARGS) {
+            memcpy(buffer + *length, &value, sizeof(T));
+            *length += sizeof(T);
+        }
+
+        Pack(buffer, length, args...);
+    }
+
+    uint8_t ring[BINARY_LOG_SIZE] = {0};
+    uint16_t head = 0;  // index of the next byte to write
+    uint16_t tail = 0;  // index of the oldest byte
+    uint16_t count = 0; // bytes currently stored
+    uint16_t dropped = 0;
+};
+
+#endif /* BINARYLOG_H */
@@ -0,0 +1,133 @@
+/*
+ *  BinaryLogDecoder.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Ground-side text reconstruction of binary log records
+ */
+
+#include "BinaryLogDecoder.h"
+#include <stdio.h>
+#include <string.h>
+
+#define PIB_LOG_MESSAGE(id, types, format) types,
+static const char * const log_types[NUM_PIB_LOG_MESSAGES] = { PIB_LOG_MESSAGE_TABLE };
+#undef PIB_LOG_MESSAGE
+
+#define PIB_LOG_MESSAGE(id, types, format) format,
+static const char * const log_formats[NUM_PIB_LOG_MESSAGES] = { PIB_LOG_MESSAGE_TABLE };
+#undef PIB_LOG_MESSAGE
+
+static uint8_t TypeSize(char type)
+{
+    switch (type) {
+    case 'b': return 1;
+    case 'h': return 2;
+    case 'u':
+    case 'i':
+    case 'f': return 4;
+    default:  return 0;
+    }
+}
+
+static uint32_t GetLE(const uint8_t * buffer, uint8_t size)
+{
+    uint32_t value = 0;
+
+    for (int i = size - 1; i >= 0; i--) {
+        value = (value << 8) | buffer[i];
+    }
+
+    return value;
+}
+
+// format a single conversion specification with one packed argument
+static int FormatArgument(char * text, uint16_t text_size, const char * spec, char type, const uint8_t * arg)
+{
+    uint32_t raw = GetLE(arg, TypeSize(type));
+    bool is_long = (NULL != strchr(spec, 'l'));
+    float f_value = 0.0f;
+
+    switch (type) {
+    case 'f':
+        memcpy(&f_value, &raw, sizeof(f_value));
+        return snprintf(text, text_size, spec, (double) f_value);
+    case 'i':
+        return is_long ? snprintf(text, text_size, spec, (long) (int32_t) raw)
+                       : snprintf(text, text_size, spec, (int) (int32_t) raw);
+    default:
+        return is_long ? snprintf(text, text_size, spec, (unsigned long) raw)
+                       : snprintf(text, text_size, spec, (unsigned int) raw);
+    }
+}
+
+uint16_t DecodeBinaryLogRecord(const uint8_t * buffer, uint16_t length, uint32_t * timestamp,
+                               char * text, uint16_t text_size)
+{
+    uint8_t id = 0;
+    uint8_t arg_length = 0;
+    uint8_t expected_length = 0;
+    const char * types = NULL;
+    const char * format = NULL;
+    const uint8_t * arg = NULL;
+    char spec[16] = {0};
+    uint16_t out = 0;
+    int written = 0;
+    int spec_length = 0;
+
+    if (length < 6 || 0 == text_size) return 0;
+
+    id = buffer[0];
+    arg_length = buffer[1];
+    *timestamp = GetLE(buffer + 2, 4);
+
+    if (length < 6 + arg_length) return 0;
+
+    if (id >= NUM_PIB_LOG_MESSAGES) {
+        snprintf(text, text_size, "Unknown binary log id: %u", id);
+        return 6 + arg_length;
+    }
+
+    types = log_types[id];
+    format = log_formats[id];
+
+    for (const char * t = types; '\0' != *t; t++) {
+        expected_length += TypeSize(*t);
+    }
+
+    if (expected_length != arg_length) {
+        snprintf(text, text_size, "Binary log id %u: bad argument length %u", id, arg_length);
+        return 6 + arg_length;
+    }
+
+    arg = buffer + 6;
+    text[0] = '\0';
+
+    while ('\0' != *format && out < text_size - 1) {
+        if ('%' != *format || '%' == format[1]) {
+            text[out++] = *format;
+            format += ('%' == *format) ? 2 : 1;
+            continue;
+        }
+
+        // copy the conversion specification up to and including its conversion character
+        spec_length = 0;
+        do {
+            spec[spec_length++] = *format++;
+        } while ('\0' != *format && NULL == strchr("diouxXfFeEgGc", format[-1]) && spec_length < (int) sizeof(spec) - 1);
+        spec[spec_length] = '\0';
+
+        if ('\0' == *types) break; // more conversions than arguments
+
+        written = FormatArgument(text + out, text_size - out, spec, *types, arg);
+        if (written < 0) break;
+
+        out += ((uint16_t) written < text_size - out) ? written : text_size - out - 1;
+        arg += TypeSize(*types);
+        types++;
+    }
+
+    text[out] = '\0';
+
+    return 6 + arg_length;
+}
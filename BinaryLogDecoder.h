@@ -0,0 +1,23 @@
+/*
+ *  BinaryLogDecoder.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Rebuilds the text of binary log records (see BinaryLog.h) using the string
+ *  table in PIBLogMessages.h. This file has no Arduino dependencies so that it
+ *  can be compiled into ground software alongside PIBLogMessages.h.
+ */
+
+#ifndef BINARYLOGDECODER_H
+#define BINARYLOGDECODER_H
+
+#include "PIBLogMessages.h"
+#include <stdint.h>
+
+// Decode the record at the start of buffer into text. Returns the number of
+// bytes consumed, or 0 if the record is truncated. Unknown ids and argument
+// lengths that don't match the table are reported in the text.
+uint16_t DecodeBinaryLogRecord(const uint8_t * buffer, uint16_t length, uint32_t * timestamp,
+                               char * text, uint16_t text_size);
+
+#endif /* BINARYLOGDECODER_H */
@@ -0,0 +1,52 @@
+/*
+ *  CommandQueue.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  A bounded FIFO of manual flight commands
+ */
+
+#include "CommandQueue.h"
+
+bool CommandQueue::Push(const QueuedCommand_t & command)
+{
+    if (count >= COMMAND_QUEUE_SIZE) {
+        dropped++;
+        return false;
+    }
+
+    queue[(head + count) % COMMAND_QUEUE_SIZE] = command;
+    count++;
+
+    return true;
+}
+
+bool CommandQueue::Pop(QueuedCommand_t * command)
+{
+    if (0 == count) return false;
+
+    *command = queue[head];
+    head = (head + 1) % COMMAND_QUEUE_SIZE;
+    count--;
+    executed++;
+
+    return true;
+}
+
+const QueuedCommand_t * CommandQueue::Peek(uint8_t index)
+{
+    if (index >= count) return nullptr;
+
+    return &queue[(head + index) % COMMAND_QUEUE_SIZE];
+}
+
+uint8_t CommandQueue::Flush()
+{
+    uint8_t discarded = count;
+
+    flushed += count;
+    head = 0;
+    count = 0;
+
+    return discarded;
+}
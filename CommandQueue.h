@@ -0,0 +1,83 @@
+/*
+ *  CommandQueue.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  A bounded FIFO of manual flight commands. Motion and sequence telecommands
+ *  are queued with their parameters instead of setting an action flag and
+ *  shared lengths, so a sequence can be uplinked in one pass and each command
+ *  runs in order once the manual flight loop is idle. A full queue drops the
+ *  new command, and CANCELMOTION or a mode change flushes it.
+ *
+ *  No Arduino dependencies.
+ */
+
+#ifndef COMMANDQUEUE_H
+#define COMMANDQUEUE_H
+
+#include <stdint.h>
+
+#define COMMAND_QUEUE_SIZE  8
+
+enum QueuedCommandType_t : uint8_t {
+    QCMD_NONE,
+    QCMD_REEL_OUT,       // deploy_length
+    QCMD_REEL_IN,        // retract_length
+    QCMD_DOCK,           // dock_length
+    QCMD_REDOCK,         // deploy_length, retract_length
+    QCMD_MANUAL_PROFILE, // profile_size, dock_amount, dock_overshoot, seconds (dwell)
+    QCMD_DOCKED_PROFILE, // seconds (docked profile time)
+    QCMD_OFFLOAD_PU,
+    QCMD_RETRANSMIT,     // night, profile, first_packet, last_packet
+    NUM_QCMD_TYPES
+};
+
+struct QueuedCommand_t {
+    QueuedCommandType_t type;
+    float deploy_length;
+    float retract_length;
+    float dock_length;
+    float profile_size;
+    float dock_amount;
+    float dock_overshoot;
+    uint16_t seconds;
+    uint16_t night;
+    uint8_t profile;
+    uint16_t first_packet;
+    uint16_t last_packet;
+};
+
+class CommandQueue {
+public:
+    CommandQueue() { };
+    ~CommandQueue() { };
+
+    // false (and counted as dropped) if the queue is full
+    bool Push(const QueuedCommand_t & command);
+
+    // false if the queue is empty
+    bool Pop(QueuedCommand_t * command);
+
+    // the index-th oldest queued command, or nullptr
+    const QueuedCommand_t * Peek(uint8_t index);
+
+    // discard every queued command, returns the number discarded
+    uint8_t Flush();
+
+    uint8_t Depth() { return count; }
+    uint16_t Dropped() { return dropped; }
+    uint16_t Flushed() { return flushed; }
+    uint16_t Executed() { return executed; }
+
+private:
+    QueuedCommand_t queue[COMMAND_QUEUE_SIZE] = {};
+    uint8_t head = 0; // index of the oldest command
+    uint8_t count = 0;
+
+    // counters since boot
+    uint16_t dropped = 0;
+    uint16_t flushed = 0;
+    uint16_t executed = 0;
+};
+
+#endif /* COMMANDQUEUE_H */
@@ -0,0 +1,58 @@
+/*
+ *  DockDetector.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Decides whether the PU is docked from UART traffic, current, and reel position
+ */
+
+#include "DockDetector.h"
+
+void DockDetector::Configure(uint16_t current_threshold, float position_tolerance)
+{
+    threshold = current_threshold;
+    tolerance = position_tolerance;
+}
+
+void DockDetector::Start(uint32_t time_ms, bool measure_current)
+{
+    start = time_ms;
+    uart_seen = false;
+    measuring = measure_current;
+    current_total = 0;
+    samples = 0;
+}
+
+void DockDetector::NoteUART(uint32_t time_ms)
+{
+    last_uart = time_ms;
+    uart_seen = true;
+}
+
+void DockDetector::AddCurrent(uint16_t counts)
+{
+    if (!measuring) return;
+
+    current_total += counts;
+    samples++;
+}
+
+void DockDetector::SetReelPosition(bool valid, float revs)
+{
+    position_valid = valid;
+    position = revs;
+}
+
+DockState_t DockDetector::Evaluate()
+{
+    // the PU can only talk over the dock contacts
+    if (uart_seen && (int32_t) (last_uart - start) >= 0) return DOCK_DOCKED;
+
+    if (0 == threshold || !measuring || samples < DOCK_MIN_SAMPLES) return DOCK_UNKNOWN;
+
+    // current with the reel paid out away from the dock is suspect (a position short of zero is drift past the dock)
+    if (position_valid && position > tolerance) return DOCK_UNKNOWN;
+
+    // a low current is left to the PU status request, since the threshold may be off
+    return (MeanCurrent() > threshold) ? DOCK_DOCKED : DOCK_UNKNOWN;
+}
@@ -0,0 +1,66 @@
+/*
+ *  DockDetector.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Decides whether the PU is docked within a detection window by fusing:
+ *    - PU UART traffic (only possible through the dock contacts)
+ *    - the PU current on IMON_PU (with PU_PWR_ENABLE set, current only flows when docked)
+ *    - the tracked reel position (a reel well away from the dock can't be docked)
+ *
+ *  Only positive evidence is used: any UART message, or a mean current above
+ *  the threshold (0 disables it) with the reel within the tolerance of the
+ *  dock, means docked. Otherwise the answer is unknown and the caller falls
+ *  back to a PU status request, which alone decides that the PU isn't docked.
+ *
+ *  No Arduino dependencies.
+ */
+
+#ifndef DOCKDETECTOR_H
+#define DOCKDETECTOR_H
+
+#include <stdint.h>
+
+#define DOCK_MIN_SAMPLES    4   // current samples before the mean is used
+
+enum DockState_t : uint8_t {
+    DOCK_UNKNOWN,
+    DOCK_DOCKED
+};
+
+class DockDetector {
+public:
+    DockDetector() { };
+    ~DockDetector() { };
+
+    // current threshold in ADC counts (0 to ignore the current), reel position tolerance in revs from the dock
+    void Configure(uint16_t current_threshold, float position_tolerance);
+
+    // begin a detection window, measure_current if the PU power is enabled
+    void Start(uint32_t time_ms, bool measure_current);
+
+    // evidence
+    void NoteUART(uint32_t time_ms);
+    void AddCurrent(uint16_t counts);
+    void SetReelPosition(bool valid, float revs);
+
+    DockState_t Evaluate();
+
+    // mean current over the window (ADC counts)
+    uint16_t MeanCurrent() { return (0 != samples) ? (uint16_t) (current_total / samples) : 0; }
+
+private:
+    uint32_t start = 0;        // ms
+    uint32_t last_uart = 0;    // ms
+    bool uart_seen = false;
+    bool measuring = false;
+    uint32_t current_total = 0;
+    uint16_t samples = 0;
+    bool position_valid = false;
+    float position = 0.0f;
+
+    uint16_t threshold = 0;
+    float tolerance = 0.0f;
+};
+
+#endif /* DOCKDETECTOR_H */
@@ -0,0 +1,100 @@
+/*
+ *  DrumModel.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Converts between reel revolutions and metres of cable paid out
+ */
+
+#include "DrumModel.h"
+#include <math.h>
+
+bool DrumModel::Configure(float core_diameter, float cable_diameter, float drum_width, float docked_length)
+{
+    valid = false;
+
+    if (core_diameter <= 0.0f || cable_diameter <= 0.0f || drum_width < cable_diameter || docked_length <= 0.0f) {
+        return false;
+    }
+
+    core = core_diameter;
+    cable = cable_diameter;
+    docked = docked_length;
+    wraps = (int) (drum_width / cable_diameter);
+
+    // the docked cable has to fit on the drum
+    valid = WoundRevolutions(docked) < (float) (wraps * DRUM_MAX_LAYERS);
+
+    return valid;
+}
+
+float DrumModel::LayerCircumference(int layer)
+{
+    return (float) M_PI * (core + cable * (2 * layer + 1));
+}
+
+float DrumModel::WoundRevolutions(float length)
+{
+    float revolutions = 0.0f;
+    float layer_length = 0.0f;
+
+    for (int layer = 0; layer < DRUM_MAX_LAYERS && length > 0.0f; layer++) {
+        layer_length = wraps * LayerCircumference(layer);
+
+        if (length <= layer_length) {
+            return revolutions + length / LayerCircumference(layer);
+        }
+
+        revolutions += wraps;
+        length -= layer_length;
+    }
+
+    return revolutions;
+}
+
+float DrumModel::WoundLength(float revolutions)
+{
+    float length = 0.0f;
+
+    for (int layer = 0; layer < DRUM_MAX_LAYERS && revolutions > 0.0f; layer++) {
+        if (revolutions <= wraps) {
+            return length + revolutions * LayerCircumference(layer);
+        }
+
+        length += wraps * LayerCircumference(layer);
+        revolutions -= wraps;
+    }
+
+    return length;
+}
+
+float DrumModel::Revolutions(float payout)
+{
+    if (!valid) return 0.0f;
+
+    // the fully paid out cable can't go any further
+    if (payout > docked) payout = docked;
+
+    return WoundRevolutions(docked) - WoundRevolutions(docked - payout);
+}
+
+float DrumModel::Payout(float revolutions)
+{
+    float docked_revolutions = 0.0f;
+
+    if (!valid) return 0.0f;
+
+    docked_revolutions = WoundRevolutions(docked);
+    if (revolutions > docked_revolutions) revolutions = docked_revolutions;
+
+    return docked - WoundLength(docked_revolutions - revolutions);
+}
+
+float DrumModel::AverageRPM(float from, float to, float speed)
+{
+    float metres = fabsf(to - from);
+
+    if (!valid || speed <= 0.0f || 0.0f == metres) return 0.0f;
+
+    return 60.0f * fabsf(Revolutions(to) - Revolutions(from)) * speed / metres;
+}
@@ -0,0 +1,54 @@
+/*
+ *  DrumModel.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Converts between reel revolutions and metres of cable paid out, allowing
+ *  for the cable layering on the drum: each layer is a whole number of wraps
+ *  across the drum width, and each wrap pays out the circumference at the
+ *  cable centerline. Positions are metres paid out from the docked position,
+ *  where docked_length metres of cable are on the drum (negative positions
+ *  are reeled in past the dock).
+ *
+ *  No Arduino dependencies.
+ */
+
+#ifndef DRUMMODEL_H
+#define DRUMMODEL_H
+
+#define DRUM_MAX_LAYERS 255
+
+class DrumModel {
+public:
+    DrumModel() { };
+    ~DrumModel() { };
+
+    // geometry in metres, returns false if it isn't usable
+    bool Configure(float core_diameter, float cable_diameter, float drum_width, float docked_length);
+
+    bool Valid() { return valid; }
+
+    // revolutions from the dock to a payout position (metres)
+    float Revolutions(float payout);
+
+    // payout position (metres) at revolutions from the dock
+    float Payout(float revolutions);
+
+    // average rpm to move between two payout positions at speed (m/s)
+    float AverageRPM(float from, float to, float speed);
+
+private:
+    // revolutions and metres of cable wound on the drum
+    float WoundRevolutions(float length);
+    float WoundLength(float revolutions);
+
+    float LayerCircumference(int layer);
+
+    float core = 0.0f;
+    float cable = 0.0f;
+    float docked = 0.0f;
+    int wraps = 0; // per layer
+    bool valid = false;
+};
+
+#endif /* DRUMMODEL_H */
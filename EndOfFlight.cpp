@@ -35,10 +35,10 @@ void StratoPIB::EndOfFlightMode()
         break;
     case EF_LOOP:
         // nominal ops
-        log_debug("EF loop");
+        PIB_LOG_DEBUG_LIMITED("EF loop");
         break;
     case EF_ERROR_LANDING:
-        log_debug("EF error");
+        PIB_LOG_DEBUG_LIMITED("EF error");
         break;
     case EF_SHUTDOWN:
         // prep for shutdown
@@ -17,21 +17,23 @@ enum FLStates_t : uint8_t {
 
     // manual
     FLM_IDLE,
-    FLM_CHECK_PU,
     FLM_MANUAL_MOTION,
     FLM_REDOCK,
     FLM_TSEN,
     FLM_PU_OFFLOAD,
     FLM_PROFILE,
     FLM_DOCKED,
+    FLM_RETRANSMIT,
 
     // autonomous
     FLA_IDLE,
     FLA_WAIT_PROFILE,
     FLA_TSEN,
     FLA_PROFILE,
+    FLA_DOCKED,
     FLA_PU_OFFLOAD,
     FLA_NOTE_PROFILE_END,
+    FLA_RETRANSMIT,
 
     // general off-nominal states
     FL_ERROR_LOOP,
@@ -56,11 +58,15 @@ void StratoPIB::FlightMode()
     case FL_ENTRY:
         // perform setup
         log_nominal("Entering FL");
+        status_poll_active = false; // a poll interrupted by a mode change starts over
+        charge_poll_active = false;
+        retransmit_machine.pending = false; // so is a retransmit
+        retransmit_machine.active = false;
         inst_substate = FL_GPS_WAIT;
         break;
     case FL_GPS_WAIT:
         // wait for the first GPS message from Zephyr to set the time before moving on
-        log_debug("Waiting on GPS time");
+        PIB_LOG_DEBUG_LIMITED("Waiting on GPS time");
         if (time_valid) {
             inst_substate = (autonomous_mode) ? FLA_IDLE : FLM_IDLE;
         }
@@ -71,13 +77,17 @@ void StratoPIB::FlightMode()
         mcb_motion_ongoing = false;
         profiles_remaining = 0;
         mcb_motion = NO_MOTION;
+        status_poll_active = false;
+        charge_poll_active = false;
+        retransmit_machine.pending = false;
+        retransmit_machine.active = false;
         mcbComm.TX_ASCII(MCB_GO_LOW_POWER);
         scheduler.AddAction(RESEND_MCB_LP, MCB_RESEND_TIMEOUT);
         mcb_low_power = false;
         inst_substate = FL_ERROR_LOOP;
         break;
     case FL_ERROR_LOOP:
-        log_debug("FL error loop");
+        PIB_LOG_DEBUG_LIMITED("FL error loop");
         if (!mcb_low_power && CheckAction(RESEND_MCB_LP)) {
             scheduler.AddAction(RESEND_MCB_LP, MCB_RESEND_TIMEOUT);
             mcbComm.TX_ASCII(MCB_GO_LOW_POWER); // just constantly send
@@ -113,95 +123,72 @@ void StratoPIB::FlightMode()
 
 void StratoPIB::ManualFlight()
 {
+    QueuedCommand_t command = {QCMD_NONE};
+
+    // PU status polls use their own instance and run alongside any manual substate
+    if (CheckAction(ACTION_CHECK_PU)) {
+        log_nominal("Check PU manual command");
+        Flight_CheckPU(status_machine, true);
+        status_poll_active = true;
+    } else if (status_poll_active && Flight_CheckPU(status_machine, false)) {
+        // only send status if the PU check succeeded (otherwise an error message will have been sent)
+        if (status_machine.success) {
+            snprintf(log_array, LOG_ARRAY_SIZE, "PU status: %lu, %0.2f, %0.2f, %0.2f, %0.2f, %u", pu_status.time, pu_status.v_battery, pu_status.i_charge, pu_status.therm1, pu_status.therm2, pu_status.heater_stat);
+            ZephyrLogFine(log_array);
+        }
+        status_poll_active = false;
+    }
+
     switch (inst_substate) {
     case FLM_IDLE:
-        log_debug("FL Manual Idle");
-        if (CheckAction(ACTION_REEL_IN)) {
-            log_nominal("Reel in manual command");
-            mcb_motion = MOTION_REEL_IN;
-            Flight_ManualMotion(true);
-            inst_substate = FLM_MANUAL_MOTION;
-        } else if (CheckAction(ACTION_REEL_OUT)) {
-            log_nominal("Reel out manual command");
-            mcb_motion = MOTION_REEL_OUT;
-            Flight_ManualMotion(true);
-            inst_substate = FLM_MANUAL_MOTION;
-        } else if (CheckAction(ACTION_DOCK)) {
-            log_nominal("Dock manual command");
-            mcb_motion = MOTION_DOCK;
-            Flight_ManualMotion(true);
-            inst_substate = FLM_MANUAL_MOTION;
-        } else if (CheckAction(ACTION_CHECK_PU)) {
-            log_nominal("Check PU manual command");
-            Flight_CheckPU(true);
-            inst_substate = FLM_CHECK_PU;
-        } else if (CheckAction(COMMAND_REDOCK)) {
-            log_nominal("Redock manual command");
-            mcb_motion = MOTION_IN_NO_LW;
-            Flight_ReDock(true);
-            inst_substate = FLM_REDOCK;
+        PIB_LOG_DEBUG_LIMITED("FL Manual Idle");
+        if (commandQueue.Pop(&command)) {
+            inst_substate = StartQueuedCommand(command);
         } else if (CheckAction(COMMAND_SEND_TSEN)) {
             log_nominal("Send TSEN manual command");
-            Flight_TSEN(true);
+            Flight_TSEN(tsen_machine, true);
             inst_substate = FLM_TSEN;
-        } else if (CheckAction(COMMAND_MANUAL_PROFILE)) {
-            log_nominal("Profile manual command");
-            Flight_Profile(true);
-            inst_substate = FLM_PROFILE;
-        } else if (CheckAction(ACTION_OFFLOAD_PU)) {
-            log_nominal("Offload PU Manual");
-            Flight_PUOffload(true);
-            inst_substate = FLM_PU_OFFLOAD;
-        } else if (CheckAction(COMMAND_DOCKED_PROFILE)) {
-            log_nominal("Docked profile");
-            Flight_DockedProfile(true);
-            inst_substate = FLM_DOCKED;
-        }
-        break;
-
-    case FLM_CHECK_PU:
-        if (Flight_CheckPU(false)) {
-            // only send status if the PU check succeeded (otherwise an error message will have been sent)
-            if (check_pu_success) {
-                snprintf(log_array, LOG_ARRAY_SIZE, "PU status: %lu, %0.2f, %0.2f, %0.2f, %0.2f, %u", pu_status.time, pu_status.v_battery, pu_status.i_charge, pu_status.therm1, pu_status.therm2, pu_status.heater_stat);
-                ZephyrLogFine(log_array);
-            }
-            inst_substate = FLM_IDLE;
         }
         break;
 
     case FLM_MANUAL_MOTION:
-        if (Flight_ManualMotion(false)) {
+        if (Flight_ManualMotion(manual_motion_machine, false)) {
             inst_substate = FLM_IDLE;
         }
         break;
 
     case FLM_REDOCK:
-        if (Flight_ReDock(false)) {
+        if (Flight_ReDock(redock_machine, false)) {
             inst_substate = FLM_IDLE;
         }
         break;
 
     case FLM_TSEN:
-        if (Flight_TSEN(false)) {
+        if (Flight_TSEN(tsen_machine, false)) {
             inst_substate = FLM_IDLE;
         }
         break;
 
     case FLM_PU_OFFLOAD:
-        if (Flight_PUOffload(false)) {
+        if (Flight_PUOffload(offload_machine, false)) {
             inst_substate = FLM_IDLE;
         }
         break;
 
     case FLM_PROFILE:
-        if (Flight_Profile(false)) {
+        if (Flight_Profile(profile_machine, false)) {
             inst_substate = FLM_IDLE;
         }
         break;
 
     case FLM_DOCKED:
-        if (Flight_DockedProfile(false)) {
+        if (Flight_DockedProfile(docked_machine, false)) {
+            inst_substate = FLM_IDLE;
+        }
+        break;
+
+    case FLM_RETRANSMIT:
+        if (Flight_Retransmit(retransmit_machine, false)) {
             inst_substate = FLM_IDLE;
         }
         break;
@@ -212,18 +199,112 @@ void StratoPIB::ManualFlight()
     };
 }
 
+uint8_t StratoPIB::StartQueuedCommand(const QueuedCommand_t & command)
+{
+    switch (command.type) {
+    case QCMD_REEL_IN:
+        log_nominal("Reel in manual command");
+        retract_length = command.retract_length;
+        mcb_motion = MOTION_REEL_IN;
+        Flight_ManualMotion(manual_motion_machine, true);
+        return FLM_MANUAL_MOTION;
+    case QCMD_REEL_OUT:
+        log_nominal("Reel out manual command");
+        deploy_length = command.deploy_length;
+        mcb_motion = MOTION_REEL_OUT;
+        Flight_ManualMotion(manual_motion_machine, true);
+        return FLM_MANUAL_MOTION;
+    case QCMD_DOCK:
+        log_nominal("Dock manual command");
+        dock_length = command.dock_length;
+        mcb_motion = MOTION_DOCK;
+        Flight_ManualMotion(manual_motion_machine, true);
+        return FLM_MANUAL_MOTION;
+    case QCMD_REDOCK:
+        log_nominal("Redock manual command");
+        deploy_length = command.deploy_length;
+        retract_length = command.retract_length;
+        mcb_motion = MOTION_IN_NO_LW;
+        Flight_ReDock(redock_machine, true);
+        return FLM_REDOCK;
+    case QCMD_MANUAL_PROFILE:
+        log_nominal("Profile manual command");
+        pibConfigs.profile_size.Write(command.profile_size);
+        pibConfigs.dock_amount.Write(command.dock_amount);
+        pibConfigs.dock_overshoot.Write(command.dock_overshoot);
+        pibConfigs.dwell_time.Write(command.seconds);
+        Flight_Profile(profile_machine, true);
+        return FLM_PROFILE;
+    case QCMD_OFFLOAD_PU:
+        log_nominal("Offload PU Manual");
+        Flight_PUOffload(offload_machine, true);
+        return FLM_PU_OFFLOAD;
+    case QCMD_DOCKED_PROFILE:
+        log_nominal("Docked profile");
+        docked_profile_time = command.seconds;
+        Flight_DockedProfile(docked_machine, true);
+        return FLM_DOCKED;
+    case QCMD_RETRANSMIT:
+        StartRetransmit(command.night, command.profile, command.first_packet, command.last_packet);
+        Flight_Retransmit(retransmit_machine, true);
+        return FLM_RETRANSMIT;
+    default:
+        log_error("Unknown queued command");
+        return FLM_IDLE;
+    }
+}
+
+uint8_t StratoPIB::StartPlanEntry()
+{
+    ProfileTable_t table = pibConfigs.profile_table.Read();
+    uint8_t index = pibConfigs.plan_index.Read();
+    const ProfileSpec_t & entry = table.entries[index];
+
+    ApplyPlanEntry(entry);
+
+    snprintf(log_array, LOG_ARRAY_SIZE, "Starting plan entry %u of %u", index + 1, table.count);
+    ZephyrLogFine(log_array);
+
+    if (PLAN_DOCKED == entry.type) {
+        Flight_DockedProfile(docked_machine, true);
+        return FLA_DOCKED;
+    }
+
+    profile_start_time = (uint32_t) now();
+    Flight_Profile(profile_machine, true);
+    return FLA_PROFILE;
+}
+
 void StratoPIB::AutonomousFlight()
 {
     switch (inst_substate) {
     case FLA_IDLE:
+        // the charge poll only runs in FLA_WAIT_PROFILE, so restart it on every return there
+        charge_poll_active = false;
+
+        // an uploaded profile table replaces the num_profiles schedule
+        if (pibConfigs.plan_mode.Read()) {
+            if (PlanEntryTriggered()) {
+                inst_substate = StartPlanEntry();
+            } else if (CheckAction(COMMAND_SEND_TSEN)) {
+                Flight_TSEN(tsen_machine, true);
+                inst_substate = FLA_TSEN;
+            } else if (retransmit_machine.pending) {
+                Flight_Retransmit(retransmit_machine, true);
+                inst_substate = FLA_RETRANSMIT;
+            }
+            break;
+        }
+
         // reset profile schedule
         if (zephyrRX.zephyr_gps.solar_zenith_angle < 45) {
             profiles_remaining = pibConfigs.num_profiles.Read();
             profiles_scheduled = false;
         }
 
-        // check for profiles or TSEN
-        if (0 != profiles_remaining && pibConfigs.sza_trigger.Read() && zephyrRX.zephyr_gps.solar_zenith_angle > pibConfigs.sza_minimum.Read()) {
+        // check for profiles or TSEN (the SZA trigger can be predicted to start the warmup early)
+        if (0 != profiles_remaining && pibConfigs.sza_trigger.Read() &&
+            (zephyrRX.zephyr_gps.solar_zenith_angle > pibConfigs.sza_minimum.Read() || SZATriggerPredicted())) {
             if (profiles_scheduled) {
                 inst_substate = FLA_WAIT_PROFILE;
             } else if (ScheduleProfiles()) { // Schedule Profiles sends result as TM
@@ -242,43 +323,105 @@ void StratoPIB::AutonomousFlight()
                 inst_substate = FL_ERROR_LANDING;
             }
         } else if (CheckAction(COMMAND_SEND_TSEN)) {
-            Flight_TSEN(true);
+            Flight_TSEN(tsen_machine, true);
             inst_substate = FLA_TSEN;
+        } else if (retransmit_machine.pending) {
+            Flight_Retransmit(retransmit_machine, true);
+            inst_substate = FLA_RETRANSMIT;
         }
         break;
 
     case FLA_WAIT_PROFILE:
+        // keep the charge model current while the PU charges on the dock
+        if (pibConfigs.charge_gate.Read()) {
+            PollPUCharge();
+        }
+
         if (CheckAction(ACTION_BEGIN_PROFILE)) {
-            Flight_Profile(true);
+            if (!ProfileDue() || HoldForCharge()) {
+                // re-planning can leave no profiles in the window
+                if (0 == profiles_remaining) inst_substate = FLA_IDLE;
+                break;
+            }
+
+            profile_start_time = (uint32_t) now();
+            Flight_Profile(profile_machine, true);
             inst_substate = FLA_PROFILE;
         } else if (CheckAction(COMMAND_SEND_TSEN)) {
-            Flight_TSEN(true);
+            Flight_TSEN(tsen_machine, true);
             inst_substate = FLA_TSEN;
+        } else if (retransmit_machine.pending) {
+            Flight_Retransmit(retransmit_machine, true);
+            inst_substate = FLA_RETRANSMIT;
         }
         break;
 
     case FLA_TSEN:
-        if (Flight_TSEN(false)) {
+        if (Flight_TSEN(tsen_machine, false)) {
+            inst_substate = FLA_IDLE;
+        }
+        break;
+
+    case FLA_RETRANSMIT:
+        if (Flight_Retransmit(retransmit_machine, false)) {
             inst_substate = FLA_IDLE;
         }
         break;
 
     case FLA_PROFILE:
-        if (Flight_Profile(false)) {
-            Flight_PUOffload(true);
+        if (Flight_Profile(profile_machine, false)) {
+            offload_start_time = (uint32_t) now();
+            Flight_PUOffload(offload_machine, true);
+            inst_substate = FLA_PU_OFFLOAD;
+        }
+        break;
+
+    case FLA_DOCKED:
+        if (Flight_DockedProfile(docked_machine, false)) {
+            offload_start_time = (uint32_t) now();
+            Flight_PUOffload(offload_machine, true);
             inst_substate = FLA_PU_OFFLOAD;
         }
         break;
 
     case FLA_PU_OFFLOAD:
-        if (Flight_PUOffload(false)) {
+        if (Flight_PUOffload(offload_machine, false)) {
+            offload_seconds = (uint32_t) now() - offload_start_time;
             inst_substate = FLA_NOTE_PROFILE_END;
         }
         break;
 
     case FLA_NOTE_PROFILE_END:
+        if (pibConfigs.plan_mode.Read()) {
+            FinishPlanEntry();
+            inst_substate = FLA_IDLE;
+            break;
+        }
+
         if (profiles_remaining != 0) profiles_remaining--;
 
+        // if the profile ran long, re-plan the rest of the night with its measured length
+        if (profilePlanner.ProfileFinished((uint32_t) now()) && 0 != profiles_remaining) {
+            ProfileDurations_t durations = {0};
+            uint32_t measured = (uint32_t) now() - profile_start_time;
+
+            EstimateProfileDurations(&durations);
+            if (measured > ProfilePlanner::ProfileSeconds(durations)) {
+                durations.offload += measured - ProfilePlanner::ProfileSeconds(durations);
+            }
+
+            profiles_remaining = profilePlanner.Plan((uint32_t) now() + PLAN_START_DELAY, profilePlanner.WindowEnd(),
+                                                     profiles_remaining, profilePlanner.Period(), durations);
+            snprintf(log_array, LOG_ARRAY_SIZE, "Profile ran long (%lu s), re-planned %u profiles", measured, profiles_remaining);
+            ZephyrLogWarn(log_array);
+            SendPlanTM();
+        }
+
+        if (!ScheduleNextProfile()) {
+            inst_substate = FL_ERROR_LANDING;
+            break;
+        }
+
         inst_substate = FLA_IDLE;
         break;
 
@@ -0,0 +1,106 @@
+/*
+ *  FlightMachines.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Instance data for the Flight_* state machines. Each Flight_* function
+ *  operates on an instance passed by its caller instead of file-scope statics,
+ *  and nested sequences are owned by the instance that runs them. Two
+ *  instances of the same sequence can therefore run at the same time (ie. a
+ *  PU status poll alongside a TSEN offload).
+ *
+ *  The constructors are defined with the state tables in each Flight_*.cpp.
+ */
+
+#ifndef FLIGHTMACHINES_H
+#define FLIGHTMACHINES_H
+
+#include "PIBStateMachine.h"
+#include "PUArchive.h"
+
+// ids reported by each Flight_* state machine for tracing
+enum StateMachineID_t : uint8_t {
+    SM_CHECK_PU,
+    SM_PROFILE,
+    SM_REDOCK,
+    SM_PU_OFFLOAD,
+    SM_TSEN,
+    SM_DOCKED_PROFILE,
+    SM_MANUAL_MOTION,
+    SM_RA,
+    SM_RETRANSMIT,
+    NUM_STATE_MACHINES
+};
+
+static_assert(NUM_STATE_MACHINES <= SM_MAX_IDS, "too many state machine ids for the trace");
+
+struct CheckPUMachine_t {
+    CheckPUMachine_t();
+    StateMachine sm;
+    uint32_t last_pu_status = 0;
+    bool success = false;
+};
+
+struct RAMachine_t {
+    RAMachine_t();
+    StateMachine sm;
+    bool acked = false;
+};
+
+struct ReDockMachine_t {
+    ReDockMachine_t();
+    StateMachine sm;
+};
+
+struct TSENMachine_t {
+    TSENMachine_t();
+    StateMachine sm;
+    CheckPUMachine_t check_pu;
+};
+
+struct PUOffloadMachine_t {
+    PUOffloadMachine_t();
+    StateMachine sm;
+    CheckPUMachine_t check_pu;
+    uint8_t packet_num = 0;
+};
+
+struct ProfileMachine_t {
+    ProfileMachine_t();
+    StateMachine sm;
+    RAMachine_t ra;
+    bool ra_pending = false; // RA running alongside the warmup
+    TSENMachine_t tsen;
+    CheckPUMachine_t check_pu;
+    ReDockMachine_t redock;
+    uint8_t redock_count = 0;
+    uint32_t zero_reel_time = 0; // ms
+};
+
+struct ManualMotionMachine_t {
+    ManualMotionMachine_t();
+    StateMachine sm;
+};
+
+struct DockedProfileMachine_t {
+    DockedProfileMachine_t();
+    StateMachine sm;
+    TSENMachine_t tsen;
+};
+
+struct RetransmitMachine_t {
+    RetransmitMachine_t();
+    StateMachine sm;
+    uint16_t night = 0;
+    uint8_t profile = 0;
+    uint16_t first_packet = 0;
+    uint16_t count = 0; // packets in the range, at most PU_ARCHIVE_RANGE
+    uint16_t next = 0; // index of the next to send
+    PUArchiveLocation_t locations[PU_ARCHIVE_RANGE];
+    uint16_t sent = 0;
+    uint16_t missing = 0;
+    bool pending = false; // requested in autonomous, waiting for the idle or profile wait
+    bool active = false;
+};
+
+#endif /* FLIGHTMACHINES_H */
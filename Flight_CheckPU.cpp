@@ -6,56 +6,70 @@
 
 #include "StratoPIB.h"
 
-enum CheckPUStates_t {
+enum CheckPUStates_t : uint8_t {
     ST_ENTRY,
-    ST_SEND_REQUEST,
     ST_WAIT_REQUEST,
+    ST_SUCCESS,
+    ST_NO_RESPONSE,
+    NUM_CHECKPU_STATES
 };
 
-static CheckPUStates_t checkpu_state = ST_ENTRY;
-static bool resend_attempted = false;
-static uint32_t last_pu_status = 0;
+enum CheckPUEvents_t : uint8_t {
+    EV_STATUS = SM_EV_USER,
+};
+
+static constexpr SMStateDef_t checkpu_states[NUM_CHECKPU_STATES] = {
+    /* ST_ENTRY        */ {0, 0},
+    /* ST_WAIT_REQUEST */ {0, 0, REQ_PU_STATUS},
+    /* ST_SUCCESS      */ {0, 0},
+    /* ST_NO_RESPONSE  */ {0, 0},
+};
+
+static constexpr SMTransition_t checkpu_transitions[] = {
+    {ST_ENTRY,        SM_EV_NEXT,    ST_WAIT_REQUEST},
+    {ST_WAIT_REQUEST, EV_STATUS,     ST_SUCCESS},
+    {ST_WAIT_REQUEST, SM_EV_TIMEOUT, ST_NO_RESPONSE},
+};
+
+CheckPUMachine_t::CheckPUMachine_t()
+    : sm(SM_CHECK_PU, checkpu_states, NUM_CHECKPU_STATES, checkpu_transitions, SM_TABLE_SIZE(checkpu_transitions))
+{
+}
 
-bool StratoPIB::Flight_CheckPU(bool restart_state)
+bool StratoPIB::Flight_CheckPU(CheckPUMachine_t & machine, bool restart_state)
 {
-    if (restart_state) checkpu_state = ST_ENTRY;
+    StateMachine & checkpu_sm = machine.sm;
 
-    switch (checkpu_state) {
+    if (restart_state) checkpu_sm.Restart();
+
+    switch (checkpu_sm.Run()) {
     case ST_ENTRY:
         log_nominal("Starting CheckPU Flight State");
-        resend_attempted = false;
-        check_pu_success = false;
-        last_pu_status = pu_status.last_status;
-        checkpu_state = ST_SEND_REQUEST;
-        break;
-
-    case ST_SEND_REQUEST:
-        puComm.TX_ASCII(PU_SEND_STATUS);
-        scheduler.AddAction(RESEND_PU_CHECK, PU_RESEND_TIMEOUT);
-        checkpu_state = ST_WAIT_REQUEST;
+        machine.success = false;
+        machine.last_pu_status = pu_status.last_status;
+        checkpu_sm.Dispatch(SM_EV_NEXT);
         break;
 
     case ST_WAIT_REQUEST:
-        if (last_pu_status != pu_status.last_status) {
-            resend_attempted = false;
-            check_pu_success = true;
-            return true;
+        // sent on entry and on each retry
+        if (checkpu_sm.Entered()) {
+            puComm.TX_ASCII(PU_SEND_STATUS);
         }
 
-        if (CheckAction(RESEND_PU_CHECK)) {
-            if (!resend_attempted) {
-                resend_attempted = true;
-                checkpu_state = ST_SEND_REQUEST;
-            } else {
-                resend_attempted = false;
-                ZephyrLogWarn("PU not responding to status request");
-                return true;
-            }
+        if (machine.last_pu_status != pu_status.last_status) {
+            checkpu_sm.Dispatch(EV_STATUS);
+            machine.success = true;
+            return true;
         }
         break;
 
+    case ST_NO_RESPONSE:
+        ZephyrLogWarn("PU not responding to status request");
+        return true;
+
+    case ST_SUCCESS:
     default:
-        // unknown state, exit
+        // finished or unknown state, exit
         return true;
     }
 
@@ -6,98 +6,113 @@
 
 #include "StratoPIB.h"
 
-enum ProfileStates_t {
-    ST_ENTRY,
-    ST_SET_PU_WARMUP,
+enum DockedProfileStates_t : uint8_t {
     ST_CONFIRM_PU_WARMUP,
     ST_WARMUP,
     ST_GET_TSEN,
-    ST_SET_PU_PREPROFILE,
     ST_CONFIRM_PU_PREPROFILE,
     ST_PREPROFILE_WAIT,
-    ST_GET_PU_STATUS,
+    ST_DONE,
+    ST_NO_WARMUP,
+    ST_NO_PREPROFILE,
+    NUM_DOCKED_STATES
 };
 
-static ProfileStates_t profile_state = ST_ENTRY;
-static bool resend_attempted = false;
+enum DockedProfileEvents_t : uint8_t {
+    EV_PU_ACK = SM_EV_USER,
+};
+
+static constexpr SMStateDef_t docked_states[NUM_DOCKED_STATES] = {
+    /* ST_CONFIRM_PU_WARMUP     */ {0, 0, REQ_PU_WARMUP},
+    /* ST_WARMUP                */ {0, 0}, // timeout set from config
+    /* ST_GET_TSEN              */ {0, 0},
+    /* ST_CONFIRM_PU_PREPROFILE */ {0, 0, REQ_PU_PREPROFILE},
+    /* ST_PREPROFILE_WAIT       */ {0, 0}, // timeout set from TC
+    /* ST_DONE                  */ {0, 0},
+    /* ST_NO_WARMUP             */ {0, 0},
+    /* ST_NO_PREPROFILE         */ {0, 0},
+};
 
-bool StratoPIB::Flight_DockedProfile(bool restart_state)
+static constexpr SMTransition_t docked_transitions[] = {
+    {ST_CONFIRM_PU_WARMUP,     EV_PU_ACK,     ST_WARMUP},
+    {ST_CONFIRM_PU_WARMUP,     SM_EV_TIMEOUT, ST_NO_WARMUP},
+    {ST_WARMUP,                SM_EV_TIMEOUT, ST_GET_TSEN},
+    {ST_GET_TSEN,              SM_EV_NEXT,    ST_CONFIRM_PU_PREPROFILE},
+    {ST_CONFIRM_PU_PREPROFILE, EV_PU_ACK,     ST_PREPROFILE_WAIT},
+    {ST_CONFIRM_PU_PREPROFILE, SM_EV_TIMEOUT, ST_NO_PREPROFILE},
+    {ST_PREPROFILE_WAIT,       SM_EV_TIMEOUT, ST_DONE},
+};
+
+DockedProfileMachine_t::DockedProfileMachine_t()
+    : sm(SM_DOCKED_PROFILE, docked_states, NUM_DOCKED_STATES, docked_transitions, SM_TABLE_SIZE(docked_transitions))
 {
-    if (restart_state) profile_state = ST_ENTRY;
-
-    switch (profile_state) {
-    case ST_ENTRY:
-    case ST_SET_PU_WARMUP:
-        pu_warmup = false;
-        puComm.TX_WarmUp(pibConfigs.flash_temp.Read(),pibConfigs.heater1_temp.Read(),pibConfigs.heater2_temp.Read(),
-                         pibConfigs.flash_power.Read(),pibConfigs.tsen_power.Read());
-        scheduler.AddAction(RESEND_PU_WARMUP, PU_RESEND_TIMEOUT);
-        profile_state = ST_CONFIRM_PU_WARMUP;
-        break;
+}
 
+bool StratoPIB::Flight_DockedProfile(DockedProfileMachine_t & machine, bool restart_state)
+{
+    StateMachine & docked_sm = machine.sm;
+
+    if (restart_state) docked_sm.Restart();
+
+    switch (docked_sm.Run()) {
     case ST_CONFIRM_PU_WARMUP:
+        // sent on entry and on each retry
+        if (docked_sm.Entered()) {
+            pu_warmup = false;
+            puComm.TX_WarmUp(pibConfigs.flash_temp.Read(),pibConfigs.heater1_temp.Read(),pibConfigs.heater2_temp.Read(),
+                             pibConfigs.flash_power.Read(),pibConfigs.tsen_power.Read());
+        }
+
         if (pu_warmup) {
-            profile_state = ST_WARMUP;
-            scheduler.AddAction(ACTION_END_WARMUP, pibConfigs.puwarmup_time.Read());
-        } else if (CheckAction(RESEND_PU_WARMUP)) {
-            if (!resend_attempted) {
-                resend_attempted = true;
-                profile_state = ST_SET_PU_WARMUP;
-            } else {
-                resend_attempted = false;
-                ZephyrLogWarn("PU not responding to warmup command");
-                return true;
-            }
+            docked_sm.Dispatch(EV_PU_ACK);
         }
         break;
 
     case ST_WARMUP:
-        if (CheckAction(ACTION_END_WARMUP)) {
-            Flight_TSEN(true);
-            profile_state = ST_GET_TSEN;
+        if (docked_sm.Entered()) {
+            docked_sm.SetTimeout(pibConfigs.puwarmup_time.Read());
         }
         break;
 
     case ST_GET_TSEN:
-        if (Flight_TSEN(false)) {
-            profile_state = ST_SET_PU_PREPROFILE;
+        if (Flight_TSEN(machine.tsen, docked_sm.Entered())) {
+            docked_sm.Dispatch(SM_EV_NEXT);
         }
         break;
 
-    case ST_SET_PU_PREPROFILE:
-        pu_preprofile = false;
-
-        // FIXME: replace the TX_PreProfile with a dedicated command, figure out data transmission
-        puComm.TX_PreProfile(docked_profile_time, 10, pibConfigs.docked_rate.Read(), pibConfigs.docked_TSEN.Read(),
-                             pibConfigs.docked_ROPC.Read(), pibConfigs.docked_FLASH.Read());
+    case ST_CONFIRM_PU_PREPROFILE:
+        // sent on entry and on each retry
+        if (docked_sm.Entered()) {
+            pu_preprofile = false;
 
-        scheduler.AddAction(RESEND_PU_GOPROFILE, PU_RESEND_TIMEOUT);
-        profile_state = ST_CONFIRM_PU_PREPROFILE;
-        break;
+            // FIXME: replace the TX_PreProfile with a dedicated command, figure out data transmission
+            puComm.TX_PreProfile(docked_profile_time, 10, pibConfigs.docked_rate.Read(), pibConfigs.docked_TSEN.Read(),
+                                 pibConfigs.docked_ROPC.Read(), pibConfigs.docked_FLASH.Read());
+        }
 
-    case ST_CONFIRM_PU_PREPROFILE:
         if (pu_preprofile) {
-            profile_state = ST_PREPROFILE_WAIT;
-            scheduler.AddAction(ACTION_END_PREPROFILE, docked_profile_time);
-        } else if (CheckAction(RESEND_PU_GOPROFILE)) {
-            if (!resend_attempted) {
-                resend_attempted = true;
-                profile_state = ST_SET_PU_PREPROFILE;
-            } else {
-                resend_attempted = false;
-                ZephyrLogWarn("PU not responding to profile command");
-                return true;
-            }
+            docked_sm.Dispatch(EV_PU_ACK);
         }
         break;
 
     case ST_PREPROFILE_WAIT:
-        if (CheckAction(ACTION_END_PREPROFILE)) {
-            ZephyrLogFine("Finished docked profile");
-            return true;
+        if (docked_sm.Entered()) {
+            docked_sm.SetTimeout(docked_profile_time);
         }
         break;
 
+    case ST_DONE:
+        ZephyrLogFine("Finished docked profile");
+        return true;
+
+    case ST_NO_WARMUP:
+        ZephyrLogWarn("PU not responding to warmup command");
+        return true;
+
+    case ST_NO_PREPROFILE:
+        ZephyrLogWarn("PU not responding to profile command");
+        return true;
+
     default:
         // unknown state, exit
         return true;
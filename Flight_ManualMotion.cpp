@@ -6,85 +6,95 @@
 
 #include "StratoPIB.h"
 
-enum ManualMotionStates_t {
-    ST_ENTRY,
+enum ManualMotionStates_t : uint8_t {
     ST_SEND_RA,
-    ST_WAIT_RAACK,
     ST_START_MOTION,
-    ST_VERIFY_MOTION,
     ST_MONITOR_MOTION,
     ST_TM_ACK,
+    ST_DONE,
+    ST_RA_NAK,
+    ST_NO_RA_ACK,
+    ST_NO_MOTION,
+    NUM_MANUALMOTION_STATES
 };
 
-static ManualMotionStates_t manualmotion_state = ST_ENTRY;
-static bool resend_attempted = false;
+enum ManualMotionEvents_t : uint8_t {
+    EV_ACK = SM_EV_USER,
+    EV_NAK,
+    EV_MOTION_STARTED,
+    EV_MOTION_DONE,
+    EV_MOTION_STOP,
+};
+
+static constexpr SMStateDef_t manualmotion_states[NUM_MANUALMOTION_STATES] = {
+    /* ST_SEND_RA        */ {0, 0, REQ_RA},
+    /* ST_START_MOTION   */ {0, 0, REQ_MCB_MOTION},
+    /* ST_MONITOR_MOTION */ {0, 0},
+    /* ST_TM_ACK         */ {0, 0, REQ_TM},
+    /* ST_DONE           */ {0, 0},
+    /* ST_RA_NAK         */ {0, 0},
+    /* ST_NO_RA_ACK      */ {0, 0},
+    /* ST_NO_MOTION      */ {0, 0},
+};
+
+static constexpr SMTransition_t manualmotion_transitions[] = {
+    {ST_SEND_RA,        EV_ACK,            ST_START_MOTION},
+    {ST_SEND_RA,        EV_NAK,            ST_RA_NAK},
+    {ST_SEND_RA,        SM_EV_TIMEOUT,     ST_NO_RA_ACK},
+    {ST_START_MOTION,   EV_MOTION_STARTED, ST_MONITOR_MOTION},
+    {ST_START_MOTION,   SM_EV_TIMEOUT,     ST_NO_MOTION},
+    {ST_MONITOR_MOTION, EV_MOTION_DONE,    ST_TM_ACK},
+    {ST_MONITOR_MOTION, EV_MOTION_STOP,    ST_DONE},
+    {ST_TM_ACK,         EV_ACK,            ST_DONE},
+    {ST_TM_ACK,         SM_EV_TIMEOUT,     ST_DONE}, // finish without the ack
+};
 
-bool StratoPIB::Flight_ManualMotion(bool restart_state)
+ManualMotionMachine_t::ManualMotionMachine_t()
+    : sm(SM_MANUAL_MOTION, manualmotion_states, NUM_MANUALMOTION_STATES, manualmotion_transitions, SM_TABLE_SIZE(manualmotion_transitions))
 {
-    if (restart_state) manualmotion_state = ST_ENTRY;
+}
 
-    switch (manualmotion_state) {
-    case ST_ENTRY:
+bool StratoPIB::Flight_ManualMotion(ManualMotionMachine_t & machine, bool restart_state)
+{
+    StateMachine & manualmotion_sm = machine.sm;
+
+    if (restart_state) manualmotion_sm.Restart();
+
+    switch (manualmotion_sm.Run()) {
     case ST_SEND_RA:
-        RA_ack_flag = NO_ACK;
-        zephyrTX.RA();
-        manualmotion_state = ST_WAIT_RAACK;
-        scheduler.AddAction(RESEND_RA, ZEPHYR_RESEND_TIMEOUT);
-        log_nominal("Sending RA");
-        break;
+        // sent on entry and on each retry
+        if (manualmotion_sm.Entered()) {
+            RA_ack_flag = NO_ACK;
+            zephyrTX.RA();
+            log_nominal("Sending RA");
+        }
 
-    case ST_WAIT_RAACK:
         if (ACK == RA_ack_flag) {
-            manualmotion_state = ST_START_MOTION;
-            resend_attempted = false;
             log_nominal("RA ACK");
+            manualmotion_sm.Dispatch(EV_ACK);
         } else if (NAK == RA_ack_flag) {
-            resend_attempted = false;
-            ZephyrLogWarn("Cannot perform motion, RA NAK");
-            return true;
-        } else if (CheckAction(RESEND_RA)) {
-            if (!resend_attempted) {
-                resend_attempted = true;
-                manualmotion_state = ST_SEND_RA;
-            } else {
-                ZephyrLogWarn("Never received RAAck");
-                resend_attempted = false;
-                return true;
-            }
+            manualmotion_sm.Dispatch(EV_NAK);
         }
         break;
 
     case ST_START_MOTION:
-        if (mcb_motion_ongoing) {
-            ZephyrLogWarn("Motion commanded while motion ongoing");
-            inst_substate = MODE_ERROR; // will force exit of Flight_Profile
-        }
+        // sent on entry and on each retry
+        if (manualmotion_sm.Entered()) {
+            if (mcb_motion_ongoing) {
+                ZephyrLogWarn("Motion commanded while motion ongoing");
+                inst_substate = MODE_ERROR; // will force exit of Flight_Profile
+            }
 
-        if (StartMCBMotion()) {
-            manualmotion_state = ST_VERIFY_MOTION;
-            scheduler.AddAction(RESEND_MOTION_COMMAND, MCB_RESEND_TIMEOUT);
-        } else {
-            ZephyrLogWarn("Motion start error");
-            inst_substate = MODE_ERROR; // will force exit of Flight_Profile
+            if (!StartMCBMotion()) {
+                ZephyrLogWarn("Motion start error");
+                inst_substate = MODE_ERROR; // will force exit of Flight_Profile
+            }
         }
-        break;
 
-    case ST_VERIFY_MOTION:
         if (mcb_motion_ongoing) { // set in the Ack handler
             log_nominal("MCB commanded motion");
             scheduler.AddAction(ACTION_MOTION_TIMEOUT, max_profile_seconds);
-            manualmotion_state = ST_MONITOR_MOTION;
-        }
-
-        if (CheckAction(RESEND_MOTION_COMMAND)) {
-            if (!resend_attempted) {
-                resend_attempted = true;
-                manualmotion_state = ST_START_MOTION;
-            } else {
-                resend_attempted = false;
-                ZephyrLogWarn("MCB never confirmed motion");
-                inst_substate = MODE_ERROR; // will force exit of Flight_Profile
-            }
+            manualmotion_sm.Dispatch(EV_MOTION_STARTED);
         }
         break;
 
@@ -92,8 +102,8 @@ bool StratoPIB::Flight_ManualMotion(bool restart_state)
         if (CheckAction(ACTION_MOTION_STOP)) {
             // todo: verification of motion stop
             ZephyrLogFine("Commanded motion stop");
+            manualmotion_sm.Dispatch(EV_MOTION_STOP);
             return true;
-            break;
         }
 
         if (CheckAction(ACTION_MOTION_TIMEOUT)) {
@@ -105,25 +115,44 @@ bool StratoPIB::Flight_ManualMotion(bool restart_state)
 
         if (!mcb_motion_ongoing) {
             SendMCBTM(FINE, "Finished commanded manual motion");
-            manualmotion_state = ST_TM_ACK;
-            scheduler.AddAction(RESEND_TM, ZEPHYR_RESEND_TIMEOUT);
+            manualmotion_sm.Dispatch(EV_MOTION_DONE);
         }
         break;
 
     case ST_TM_ACK:
-        if (ACK == TM_ack_flag) {
-            log_nominal("Zephyr ACKed motion TM");
-            return true;
-        } else if (NAK == TM_ack_flag || CheckAction(RESEND_TM)) {
-            // attempt one resend
+        // the TM is sent when the motion finishes, resend on each retry
+        if (manualmotion_sm.Entered() && 0 != manualmotion_sm.RetryCount()) {
             log_error("Needed to resend TM");
+            TM_ack_flag = NO_ACK;
             zephyrTX.TM(); // message is still saved in XMLWriter, no need to reconstruct
+        }
+
+        if (ACK == TM_ack_flag) {
+            log_nominal("Zephyr ACKed motion TM");
+            manualmotion_sm.Dispatch(EV_ACK);
             return true;
+        } else if (NAK == TM_ack_flag) {
+            TM_ack_flag = NO_ACK;
+            manualmotion_sm.Retry();
         }
         break;
 
+    case ST_RA_NAK:
+        ZephyrLogWarn("Cannot perform motion, RA NAK");
+        return true;
+
+    case ST_NO_RA_ACK:
+        ZephyrLogWarn("Never received RAAck");
+        return true;
+
+    case ST_NO_MOTION:
+        ZephyrLogWarn("MCB never confirmed motion");
+        inst_substate = MODE_ERROR; // will force exit of Flight_Profile
+        return true;
+
+    case ST_DONE:
     default:
-        // unknown state, exit
+        // finished or unknown state, exit
         return true;
     }
 
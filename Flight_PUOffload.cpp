@@ -6,92 +6,106 @@
 
 #include "StratoPIB.h"
 
-enum PUOffloadStates_t {
-    ST_ENTRY,
+enum PUOffloadStates_t : uint8_t {
     ST_GET_PU_STATUS,
-    ST_WAIT_PU_STATUS,
-    ST_REQUEST_PACKET,
     ST_WAIT_PACKET,
     ST_TM_ACK,
+    ST_DONE,
+    ST_NO_PACKET,
+    NUM_PUOFFLOAD_STATES
 };
 
-static PUOffloadStates_t puoffload_state = ST_ENTRY;
-static bool resend_attempted = false;
-static uint8_t packet_num = 0;
+enum PUOffloadEvents_t : uint8_t {
+    EV_RECORD = SM_EV_USER,
+    EV_NO_MORE_RECORDS,
+    EV_ACK,
+};
+
+static constexpr SMStateDef_t puoffload_states[NUM_PUOFFLOAD_STATES] = {
+    /* ST_GET_PU_STATUS */ {0, 0},
+    /* ST_WAIT_PACKET   */ {0, 0, REQ_PU_RECORD},
+    /* ST_TM_ACK        */ {0, 0, REQ_TM},
+    /* ST_DONE          */ {0, 0},
+    /* ST_NO_PACKET     */ {0, 0},
+};
 
-bool StratoPIB::Flight_PUOffload(bool restart_state)
+static constexpr SMTransition_t puoffload_transitions[] = {
+    {ST_GET_PU_STATUS, SM_EV_NEXT,         ST_WAIT_PACKET},
+    {ST_WAIT_PACKET,   EV_RECORD,          ST_TM_ACK},
+    {ST_WAIT_PACKET,   EV_NO_MORE_RECORDS, ST_DONE},
+    {ST_WAIT_PACKET,   SM_EV_TIMEOUT,      ST_NO_PACKET},
+    {ST_TM_ACK,        EV_ACK,             ST_GET_PU_STATUS},
+    {ST_TM_ACK,        SM_EV_TIMEOUT,      ST_GET_PU_STATUS}, // move on without the ack
+};
+
+PUOffloadMachine_t::PUOffloadMachine_t()
+    : sm(SM_PU_OFFLOAD, puoffload_states, NUM_PUOFFLOAD_STATES, puoffload_transitions, SM_TABLE_SIZE(puoffload_transitions))
 {
-    if (restart_state) puoffload_state = ST_ENTRY;
+}
 
-    switch (puoffload_state) {
-    case ST_ENTRY:
-        resend_attempted = false;
-        packet_num = 0;
-        puoffload_state = ST_GET_PU_STATUS;
-        break;
+bool StratoPIB::Flight_PUOffload(PUOffloadMachine_t & machine, bool restart_state)
+{
+    StateMachine & puoffload_sm = machine.sm;
 
-    case ST_GET_PU_STATUS:
-        Flight_CheckPU(true);
-        puoffload_state = ST_WAIT_PU_STATUS;
-        break;
+    if (restart_state) {
+        machine.packet_num = 0;
+        NoteArchiveProfile();
+        puoffload_sm.Restart();
+    }
 
-    case ST_WAIT_PU_STATUS:
-        if (Flight_CheckPU(false)) {
-            puoffload_state = ST_REQUEST_PACKET;
+    switch (puoffload_sm.Run()) {
+    case ST_GET_PU_STATUS:
+        if (Flight_CheckPU(machine.check_pu, puoffload_sm.Entered())) {
+            puoffload_sm.Dispatch(SM_EV_NEXT);
         }
         break;
 
-    case ST_REQUEST_PACKET:
-        puComm.TX_ASCII(PU_SEND_PROFILE_RECORD);
-        scheduler.AddAction(RESEND_PU_RECORD, PU_RESEND_TIMEOUT);
-        record_received = false;
-        pu_no_more_records = false;
-        puoffload_state = ST_WAIT_PACKET;
-        break;
-
     case ST_WAIT_PACKET:
+        // sent on entry and on each retry
+        if (puoffload_sm.Entered()) {
+            puComm.TX_ASCII(PU_SEND_PROFILE_RECORD);
+            record_received = false;
+            pu_no_more_records = false;
+        }
+
         if (record_received) { // ACK/NAK in PURouter
             record_received = false;
-            packet_num++;
-            snprintf(log_array, LOG_ARRAY_SIZE, "Received profile record: %u", puComm.binary_rx.bin_length);
-            log_nominal(log_array);
-            SendProfileTM(packet_num);
-            puoffload_state = ST_TM_ACK;
-            scheduler.AddAction(RESEND_TM, ZEPHYR_RESEND_TIMEOUT);
-            break;
+            machine.packet_num++;
+            binaryLog.Log(BL_RECORD_RECEIVED, puComm.binary_rx.bin_length);
+            ArchivePURecord(pibConfigs.archive_profile.Read(), machine.packet_num);
+            SendProfileTM(machine.packet_num);
+            puoffload_sm.Dispatch(EV_RECORD);
         } else if (pu_no_more_records) {
             pu_no_more_records = false;
             log_nominal("No more profile records");
+            puoffload_sm.Dispatch(EV_NO_MORE_RECORDS);
             return true;
         }
-
-        if (CheckAction(RESEND_PU_RECORD)) {
-            if (!resend_attempted) {
-                resend_attempted = true;
-                puoffload_state = ST_REQUEST_PACKET;
-            } else {
-                resend_attempted = false;
-                ZephyrLogWarn("PU not successful in sending profile record");
-                return true;
-            }
-        }
         break;
 
     case ST_TM_ACK:
-        if (ACK == TM_ack_flag) {
-            resend_attempted = false;
-            puoffload_state = ST_GET_PU_STATUS;
-        } else if (NAK == TM_ack_flag || CheckAction(RESEND_TM)) {
-            // attempt one resend
+        // the TM is sent with the record, resend on each retry
+        if (puoffload_sm.Entered() && 0 != puoffload_sm.RetryCount()) {
             log_error("Needed to resend TM");
+            TM_ack_flag = NO_ACK;
             zephyrTX.TM(); // message is still saved in XMLWriter, no need to reconstruct
-            resend_attempted = false;
-            puoffload_state = ST_GET_PU_STATUS;
+        }
+
+        if (ACK == TM_ack_flag) {
+            puoffload_sm.Dispatch(EV_ACK);
+        } else if (NAK == TM_ack_flag) {
+            TM_ack_flag = NO_ACK;
+            puoffload_sm.Retry();
         }
         break;
 
+    case ST_NO_PACKET:
+        ZephyrLogWarn("PU not successful in sending profile record");
+        return true;
+
+    case ST_DONE:
     default:
-        // unknown state, exit
+        // finished or unknown state, exit
         return true;
     }
 
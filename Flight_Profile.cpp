@@ -6,16 +6,13 @@
 
 #include "StratoPIB.h"
 
-enum ProfileStates_t {
-    ST_ENTRY,
+enum ProfileStates_t : uint8_t {
+    ST_START,
     ST_SEND_RA,
-    ST_WAIT_RAACK,
-    ST_HOUSKEEPING_CHECK,
-    ST_SET_PU_WARMUP,
     ST_CONFIRM_PU_WARMUP,
     ST_WARMUP,
     ST_GET_TSEN,
-    ST_SET_PU_PROFILE,
+    ST_WAIT_RA,
     ST_CONFIRM_PU_PROFILE,
     ST_PREPROFILE_WAIT,
     ST_REEL_OUT,
@@ -23,229 +20,319 @@ enum ProfileStates_t {
     ST_REEL_IN,
     ST_DOCK_WAIT,
     ST_DOCK,
+    ST_START_MOTION,
+    ST_MONITOR_MOTION,
+    ST_DETECT_DOCK,
     ST_GET_PU_STATUS,
     ST_VERIFY_DOCK,
+    ST_ZERO_REEL,
     ST_REDOCK,
-    ST_START_MOTION,
-    ST_VERIFY_MOTION,
-    ST_MONITOR_MOTION,
     ST_CONFIRM_MCB_LP,
+    ST_CANCEL_WARMUP,
+    ST_DONE,
+    ST_NO_RA,
+    ST_NO_WARMUP,
+    ST_NO_PROFILE,
+    ST_NO_MOTION,
+    ST_NO_MCB_LP,
+    NUM_PROFILE_STATES
 };
 
-static ProfileStates_t profile_state = ST_ENTRY;
-static bool resend_attempted = false;
-static uint8_t redock_count = 0;
+enum ProfileEvents_t : uint8_t {
+    EV_ACK = SM_EV_USER,
+    EV_NAK,
+    EV_PARALLEL_RA,
+    EV_MOTION_STARTED,
+    EV_OUT_DONE,
+    EV_IN_DONE,
+    EV_DOCK_DONE,
+    EV_DOCKED,
+    EV_NOT_DOCKED,
+};
 
-bool StratoPIB::Flight_Profile(bool restart_state)
+static constexpr SMStateDef_t profile_states[NUM_PROFILE_STATES] = {
+    /* ST_START              */ {0, 0},
+    /* ST_SEND_RA            */ {0, 0},
+    /* ST_CONFIRM_PU_WARMUP  */ {0, 0, REQ_PU_WARMUP},
+    /* ST_WARMUP             */ {0, 0}, // timeout set from config
+    /* ST_GET_TSEN           */ {0, 0},
+    /* ST_WAIT_RA            */ {0, 0},
+    /* ST_CONFIRM_PU_PROFILE */ {0, 0, REQ_PU_PROFILE},
+    /* ST_PREPROFILE_WAIT    */ {0, 0}, // timeout set from config
+    /* ST_REEL_OUT           */ {0, 0},
+    /* ST_DWELL              */ {0, 0}, // timeout set from config
+    /* ST_REEL_IN            */ {0, 0},
+    /* ST_DOCK_WAIT          */ {DOCK_WAIT_TIME, 0},
+    /* ST_DOCK               */ {0, 0},
+    /* ST_START_MOTION       */ {0, 0, REQ_MCB_MOTION},
+    /* ST_MONITOR_MOTION     */ {0, 0},
+    /* ST_DETECT_DOCK        */ {DOCK_DETECT_TIMEOUT, 0},
+    /* ST_GET_PU_STATUS      */ {0, 0},
+    /* ST_VERIFY_DOCK        */ {0, 0},
+    /* ST_ZERO_REEL          */ {0, 0},
+    /* ST_REDOCK             */ {0, 0},
+    /* ST_CONFIRM_MCB_LP     */ {0, 0, REQ_MCB_LOW_POWER},
+    /* ST_CANCEL_WARMUP      */ {0, 0, REQ_PU_RESET},
+    /* ST_DONE               */ {0, 0},
+    /* ST_NO_RA              */ {0, 0},
+    /* ST_NO_WARMUP          */ {0, 0},
+    /* ST_NO_PROFILE         */ {0, 0},
+    /* ST_NO_MOTION          */ {0, 0},
+    /* ST_NO_MCB_LP          */ {0, 0},
+};
+
+static constexpr SMTransition_t profile_transitions[] = {
+    {ST_START,              SM_EV_NEXT,        ST_SEND_RA},
+    {ST_START,              EV_PARALLEL_RA,    ST_CONFIRM_PU_WARMUP},
+    {ST_SEND_RA,            EV_ACK,            ST_CONFIRM_PU_WARMUP},
+    {ST_SEND_RA,            EV_NAK,            ST_NO_RA},
+    {ST_CONFIRM_PU_WARMUP,  EV_ACK,            ST_WARMUP},
+    {ST_CONFIRM_PU_WARMUP,  SM_EV_TIMEOUT,     ST_NO_WARMUP},
+    {ST_CONFIRM_PU_WARMUP,  SM_EV_CANCEL,      ST_CANCEL_WARMUP},
+    {ST_WARMUP,             SM_EV_TIMEOUT,     ST_GET_TSEN},
+    {ST_WARMUP,             SM_EV_CANCEL,      ST_CANCEL_WARMUP},
+    {ST_GET_TSEN,           SM_EV_NEXT,        ST_WAIT_RA},
+    {ST_GET_TSEN,           SM_EV_CANCEL,      ST_CANCEL_WARMUP},
+    {ST_WAIT_RA,            SM_EV_NEXT,        ST_CONFIRM_PU_PROFILE},
+    {ST_WAIT_RA,            SM_EV_CANCEL,      ST_CANCEL_WARMUP},
+    {ST_CONFIRM_PU_PROFILE, EV_ACK,            ST_PREPROFILE_WAIT},
+    {ST_CONFIRM_PU_PROFILE, SM_EV_TIMEOUT,     ST_NO_PROFILE},
+    {ST_PREPROFILE_WAIT,    SM_EV_TIMEOUT,     ST_REEL_OUT},
+    {ST_REEL_OUT,           SM_EV_NEXT,        ST_START_MOTION},
+    {ST_DWELL,              SM_EV_TIMEOUT,     ST_REEL_IN},
+    {ST_REEL_IN,            SM_EV_NEXT,        ST_START_MOTION},
+    {ST_DOCK_WAIT,          SM_EV_NEXT,        ST_DOCK},
+    {ST_DOCK_WAIT,          SM_EV_TIMEOUT,     ST_DOCK},
+    {ST_DOCK,               SM_EV_NEXT,        ST_START_MOTION},
+    {ST_START_MOTION,       EV_MOTION_STARTED, ST_MONITOR_MOTION},
+    {ST_START_MOTION,       SM_EV_TIMEOUT,     ST_NO_MOTION},
+    {ST_MONITOR_MOTION,     EV_OUT_DONE,       ST_DWELL},
+    {ST_MONITOR_MOTION,     EV_IN_DONE,        ST_DOCK_WAIT},
+    {ST_MONITOR_MOTION,     EV_DOCK_DONE,      ST_DETECT_DOCK},
+    {ST_DETECT_DOCK,        SM_EV_NEXT,        ST_VERIFY_DOCK},
+    {ST_DETECT_DOCK,        SM_EV_TIMEOUT,     ST_GET_PU_STATUS},
+    {ST_GET_PU_STATUS,      SM_EV_NEXT,        ST_VERIFY_DOCK},
+    {ST_VERIFY_DOCK,        EV_DOCKED,         ST_ZERO_REEL},
+    {ST_VERIFY_DOCK,        EV_NOT_DOCKED,     ST_REDOCK},
+    {ST_ZERO_REEL,          SM_EV_NEXT,        ST_CONFIRM_MCB_LP},
+    {ST_REDOCK,             SM_EV_NEXT,        ST_GET_PU_STATUS},
+    {ST_CONFIRM_MCB_LP,     EV_ACK,            ST_DONE},
+    {ST_CONFIRM_MCB_LP,     SM_EV_TIMEOUT,     ST_NO_MCB_LP},
+    {ST_CANCEL_WARMUP,      EV_ACK,            ST_NO_RA},
+    {ST_CANCEL_WARMUP,      SM_EV_TIMEOUT,     ST_NO_RA},
+};
+
+ProfileMachine_t::ProfileMachine_t()
+    : sm(SM_PROFILE, profile_states, NUM_PROFILE_STATES, profile_transitions, SM_TABLE_SIZE(profile_transitions))
 {
-    if (restart_state) profile_state = ST_ENTRY;
+}
 
-    switch (profile_state) {
-    case ST_ENTRY:
-    case ST_SEND_RA:
-        RA_ack_flag = NO_ACK;
-        zephyrTX.RA();
-        profile_state = ST_WAIT_RAACK;
-        scheduler.AddAction(RESEND_RA, ZEPHYR_RESEND_TIMEOUT);
-        log_nominal("Sending RA");
-        break;
+bool StratoPIB::Flight_Profile(ProfileMachine_t & machine, bool restart_state)
+{
+    StateMachine & profile_sm = machine.sm;
 
-    case ST_WAIT_RAACK:
-        log_debug("FLA wait RA Ack");
-        if (ACK == RA_ack_flag) {
-            profile_state = ST_HOUSKEEPING_CHECK;
-            resend_attempted = false;
-            log_nominal("RA ACK");
-        } else if (NAK == RA_ack_flag) {
-            ZephyrLogWarn("Cannot perform motion, RA NAK");
-            resend_attempted = false;
-            return true;
-        } else if (CheckAction(RESEND_RA)) {
-            if (!resend_attempted) {
-                resend_attempted = true;
-                profile_state = ST_SEND_RA;
-            } else {
-                ZephyrLogWarn("Never received RAAck");
-                resend_attempted = false;
-                return true;
-            }
+    if (restart_state) {
+        machine.ra_pending = false;
+        profile_sm.Restart();
+    }
+
+    // in parallel mode the RA runs alongside the warmup, which is cancelled if the RA fails
+    if (machine.ra_pending && Flight_RA(machine.ra, false)) {
+        machine.ra_pending = false;
+        if (!machine.ra.acked) {
+            profile_sm.Dispatch(SM_EV_CANCEL);
         }
-        break;
+    }
 
-    case ST_HOUSKEEPING_CHECK:
-        profile_state = ST_SET_PU_WARMUP;
-        resend_attempted = false;
+    switch (profile_sm.Run()) {
+    case ST_START:
+        if (pibConfigs.parallel_ra.Read()) {
+            log_nominal("Starting RA and PU warmup in parallel");
+            Flight_RA(machine.ra, true);
+            machine.ra_pending = true;
+            profile_sm.Dispatch(EV_PARALLEL_RA);
+        } else {
+            profile_sm.Dispatch(SM_EV_NEXT);
+        }
         break;
 
-    case ST_SET_PU_WARMUP:
-        pu_warmup = false;
-        puComm.TX_WarmUp(pibConfigs.flash_temp.Read(),pibConfigs.heater1_temp.Read(),pibConfigs.heater2_temp.Read(),
-                         pibConfigs.flash_power.Read(),pibConfigs.tsen_power.Read());
-        scheduler.AddAction(RESEND_PU_WARMUP, PU_RESEND_TIMEOUT);
-        profile_state = ST_CONFIRM_PU_WARMUP;
+    case ST_SEND_RA:
+        if (Flight_RA(machine.ra, profile_sm.Entered())) {
+            profile_sm.Dispatch(machine.ra.acked ? EV_ACK : EV_NAK);
+        }
         break;
 
     case ST_CONFIRM_PU_WARMUP:
+        // sent on entry and on each retry
+        if (profile_sm.Entered()) {
+            pu_warmup = false;
+            puComm.TX_WarmUp(pibConfigs.flash_temp.Read(),pibConfigs.heater1_temp.Read(),pibConfigs.heater2_temp.Read(),
+                             pibConfigs.flash_power.Read(),pibConfigs.tsen_power.Read());
+        }
+
         if (pu_warmup) {
-            profile_state = ST_WARMUP;
-            scheduler.AddAction(ACTION_END_WARMUP, pibConfigs.puwarmup_time.Read());
-        } else if (CheckAction(RESEND_PU_WARMUP)) {
-            if (!resend_attempted) {
-                resend_attempted = true;
-                profile_state = ST_SET_PU_WARMUP;
-            } else {
-                resend_attempted = false;
-                ZephyrLogWarn("PU not responding to warmup command");
-                return true;
-            }
+            profile_sm.Dispatch(EV_ACK);
         }
         break;
 
     case ST_WARMUP:
-        if (CheckAction(ACTION_END_WARMUP)) {
-            Flight_TSEN(true);
-            profile_state = ST_GET_TSEN;
+        if (profile_sm.Entered()) {
+            profile_sm.SetTimeout(pibConfigs.puwarmup_time.Read());
         }
         break;
 
     case ST_GET_TSEN:
-        if (Flight_TSEN(false)) {
-            profile_state = ST_SET_PU_PROFILE;
+        if (Flight_TSEN(machine.tsen, profile_sm.Entered())) {
+            profile_sm.Dispatch(SM_EV_NEXT);
         }
         break;
 
-    case ST_SET_PU_PROFILE:
-        retract_length = pibConfigs.profile_size.Read() - pibConfigs.dock_amount.Read();
-        deploy_length = pibConfigs.profile_size.Read();
-        dock_length = pibConfigs.dock_amount.Read() + pibConfigs.dock_overshoot.Read();
-        pu_profile = false;
-        PUStartProfile();
-        scheduler.AddAction(RESEND_PU_GOPROFILE, PU_RESEND_TIMEOUT);
-        profile_state = ST_CONFIRM_PU_PROFILE;
+    case ST_WAIT_RA:
+        // join on the RA if it was started in parallel (it either succeeds or cancels the profile)
+        if (!machine.ra_pending) {
+            profile_sm.Dispatch(SM_EV_NEXT);
+        }
+        PIB_LOG_DEBUG_LIMITED("FLA wait RA Ack");
         break;
 
     case ST_CONFIRM_PU_PROFILE:
+        // sent on entry and on each retry
+        if (profile_sm.Entered()) {
+            retract_length = pibConfigs.profile_size.Read() - pibConfigs.dock_amount.Read();
+            deploy_length = pibConfigs.profile_size.Read();
+            dock_length = pibConfigs.dock_amount.Read() + pibConfigs.dock_overshoot.Read();
+            pu_profile = false;
+            PUStartProfile();
+        }
+
         if (pu_profile) {
-            profile_state = ST_PREPROFILE_WAIT;
-            scheduler.AddAction(ACTION_END_PREPROFILE, pibConfigs.preprofile_time.Read());
-        } else if (CheckAction(RESEND_PU_GOPROFILE)) {
-            if (!resend_attempted) {
-                resend_attempted = true;
-                profile_state = ST_SET_PU_PROFILE;
-            } else {
-                resend_attempted = false;
-                ZephyrLogWarn("PU not responding to profile command");
-                return true;
-            }
+            profile_sm.Dispatch(EV_ACK);
         }
         break;
 
     case ST_PREPROFILE_WAIT:
-        if (CheckAction(ACTION_END_PREPROFILE)) {
-            profile_state = ST_REEL_OUT;
-            resend_attempted = false;
+        if (profile_sm.Entered()) {
+            profile_sm.SetTimeout(pibConfigs.preprofile_time.Read());
         }
         break;
 
     case ST_REEL_OUT:
-        log_debug("FLA reel out");
+        PIB_LOG_DEBUG("FLA reel out");
         mcb_motion = MOTION_REEL_OUT;
-        profile_state = ST_START_MOTION;
-        resend_attempted = false;
+        profile_sm.Dispatch(SM_EV_NEXT);
         break;
 
     case ST_REEL_IN:
-        log_debug("FLA reel in");
+        log_nominal("Finished dwell");
+        PIB_LOG_DEBUG("FLA reel in");
         mcb_motion = MOTION_REEL_IN;
-        profile_state = ST_START_MOTION;
-        resend_attempted = false;
+        profile_sm.Dispatch(SM_EV_NEXT);
         break;
 
     case ST_DOCK_WAIT:
-        // wait for the timeout set for the reel out or the backup action, whichever comes first
-        if (CheckAction(ACTION_MOTION_TIMEOUT) || CheckAction(ACTION_END_DOCK_WAIT)) {
-            profile_state = ST_DOCK;
+        // listen for the PU in case the reel in already docked it (the power stays off until then)
+        if (profile_sm.Entered()) {
+            StartDockDetection(false);
+        }
+
+        // the dock motion still runs to seat the PU, only the rest of the wait is skipped
+        if (DOCK_DOCKED == DetectDock()) {
+            log_nominal("PU docked during dock wait");
+            profile_sm.Dispatch(SM_EV_NEXT);
+            break;
+        }
+
+        // wait for the timeout set for the reel in or the state timeout, whichever comes first
+        if (CheckAction(ACTION_MOTION_TIMEOUT)) {
+            profile_sm.Dispatch(SM_EV_NEXT);
         }
         break;
 
     case ST_DOCK:
-        log_debug("FLA dock");
+        PIB_LOG_DEBUG("FLA dock");
+        dock_length = DockRevs(pibConfigs.dock_amount.Read() + pibConfigs.dock_overshoot.Read(), pibConfigs.profile_size.Read());
         mcb_motion = MOTION_DOCK;
-        profile_state = ST_START_MOTION;
-        resend_attempted = false;
+        profile_sm.Dispatch(SM_EV_NEXT);
+        break;
+
+    case ST_DETECT_DOCK:
+        // prompt the PU and power the dock contacts, then move on as soon as it is seen docked
+        if (profile_sm.Entered()) {
+            StartDockDetection(true);
+            puComm.TX_ASCII(PU_SEND_STATUS);
+        }
+
+        // otherwise the PU status request on the state timeout decides
+        if (DOCK_DOCKED == DetectDock()) {
+            PUDock();
+            profile_sm.Dispatch(SM_EV_NEXT);
+        }
         break;
 
     case ST_GET_PU_STATUS:
-        if (Flight_CheckPU(false)) {
-            profile_state = ST_VERIFY_DOCK;
+        if (Flight_CheckPU(machine.check_pu, profile_sm.Entered())) {
+            profile_sm.Dispatch(SM_EV_NEXT);
         }
         break;
 
     case ST_VERIFY_DOCK:
         if (pibConfigs.pu_docked.Read()) {
-            mcbComm.TX_ASCII(MCB_ZERO_REEL);
-            delay(100);
-            mcbComm.TX_ASCII(MCB_GO_LOW_POWER);
-            scheduler.AddAction(RESEND_MCB_LP, MCB_RESEND_TIMEOUT);
-            profile_state = ST_CONFIRM_MCB_LP;
+            profile_sm.Dispatch(EV_DOCKED);
         } else {
-            if ((pibConfigs.num_redock.Read() + 1) == ++redock_count) {
+            if ((pibConfigs.num_redock.Read() + 1) == ++machine.redock_count) {
                 ZephyrLogCrit("No dock! Exceeded allowable number of redock attempts");
                 inst_substate = MODE_ERROR; // will force exit of Flight_Profile
             } else {
                 deploy_length = pibConfigs.redock_out.Read();
                 retract_length = pibConfigs.redock_in.Read();
-                Flight_ReDock(true);
-                profile_state = ST_REDOCK;
+                profile_sm.Dispatch(EV_NOT_DOCKED);
             }
         }
         break;
 
+    case ST_ZERO_REEL:
+        // give the MCB time to handle the zero before the low power command
+        if (profile_sm.Entered()) {
+            mcbComm.TX_ASCII(MCB_ZERO_REEL);
+            machine.zero_reel_time = millis();
+        }
+
+        if (millis() - machine.zero_reel_time >= MCB_ZERO_REEL_GAP) {
+            profile_sm.Dispatch(SM_EV_NEXT);
+        }
+        break;
+
     case ST_REDOCK:
-        if (Flight_ReDock(false)) {
-            Flight_CheckPU(true);
-            profile_state = ST_GET_PU_STATUS;
+        if (Flight_ReDock(machine.redock, profile_sm.Entered())) {
+            profile_sm.Dispatch(SM_EV_NEXT);
         }
         break;
 
     case ST_START_MOTION:
-        log_debug("FLA start motion");
-        if (mcb_motion_ongoing) {
-            ZephyrLogWarn("Motion commanded while motion ongoing");
-            inst_substate = MODE_ERROR; // will force exit of Flight_Profile
-        }
+        // sent on entry and on each retry
+        if (profile_sm.Entered()) {
+            PIB_LOG_DEBUG("FLA start motion");
+            if (mcb_motion_ongoing) {
+                ZephyrLogWarn("Motion commanded while motion ongoing");
+                inst_substate = MODE_ERROR; // will force exit of Flight_Profile
+            }
 
-        if (StartMCBMotion()) {
-            profile_state = ST_VERIFY_MOTION;
-            scheduler.AddAction(RESEND_MOTION_COMMAND, MCB_RESEND_TIMEOUT);
-        } else {
-            ZephyrLogWarn("Motion start error");
-            inst_substate = MODE_ERROR; // will force exit of Flight_Profile
+            if (!StartMCBMotion()) {
+                ZephyrLogWarn("Motion start error");
+                inst_substate = MODE_ERROR; // will force exit of Flight_Profile
+            }
         }
-        break;
 
-    case ST_VERIFY_MOTION:
-        log_debug("FLA verify motion");
+        PIB_LOG_DEBUG_LIMITED("FLA verify motion");
         if (mcb_motion_ongoing) { // set in the Ack handler
             log_nominal("MCB commanded motion");
             scheduler.AddAction(ACTION_MOTION_TIMEOUT, max_profile_seconds);
-            profile_state = ST_MONITOR_MOTION;
-        }
-
-        if (CheckAction(RESEND_MOTION_COMMAND)) {
-            if (!resend_attempted) {
-                resend_attempted = true;
-                profile_state = ST_START_MOTION;
-            } else {
-                resend_attempted = false;
-                ZephyrLogWarn("MCB never confirmed motion");
-                inst_substate = MODE_ERROR; // will force exit of Flight_Profile
-            }
+            profile_sm.Dispatch(EV_MOTION_STARTED);
         }
         break;
 
     case ST_MONITOR_MOTION:
-        log_debug("FLA monitor motion");
+        PIB_LOG_DEBUG_LIMITED("FLA monitor motion");
 
         if (CheckAction(ACTION_MOTION_STOP)) {
             ZephyrLogWarn("Commanded motion stop in autonomous");
@@ -265,25 +352,17 @@ bool StratoPIB::Flight_Profile(bool restart_state)
             switch (mcb_motion) {
             case MOTION_REEL_OUT:
                 SendMCBTM(FINE, "Finished profile reel out");
-                if (scheduler.AddAction(ACTION_END_DWELL, pibConfigs.dwell_time.Read())) {
-                    snprintf(log_array, LOG_ARRAY_SIZE, "Scheduled dwell: %u s", pibConfigs.dwell_time.Read());
-                    log_nominal(log_array);
-                    profile_state = ST_DWELL;
-                } else {
-                    ZephyrLogCrit("Unable to schedule dwell");
-                    inst_substate = MODE_ERROR; // will force exit of Flight_Profile
-                }
+                binaryLog.Log(BL_SCHEDULED_DWELL, pibConfigs.dwell_time.Read());
+                profile_sm.Dispatch(EV_OUT_DONE);
                 break;
             case MOTION_REEL_IN:
                 SendMCBTM(FINE, "Finished profile reel in");
-                scheduler.AddAction(ACTION_END_DOCK_WAIT, 60);
-                profile_state = ST_DOCK_WAIT;
+                profile_sm.Dispatch(EV_IN_DONE);
                 break;
             case MOTION_DOCK:
                 // MCB TM sent in MCBRouter handler for MCB_MOTION_FAULT
-                redock_count = 0;
-                Flight_CheckPU(true); // start checking the PU
-                profile_state = ST_GET_PU_STATUS;
+                machine.redock_count = 0;
+                profile_sm.Dispatch(EV_DOCK_DONE);
                 break;
             default:
                 SendMCBTM(CRIT, "Unknown motion finished in profile monitor");
@@ -294,32 +373,61 @@ bool StratoPIB::Flight_Profile(bool restart_state)
         break;
 
     case ST_DWELL:
-        log_debug("FLA dwell");
-        if (CheckAction(ACTION_END_DWELL)) {
-            log_nominal("Finished dwell");
-            profile_state = ST_REEL_IN;
+        if (profile_sm.Entered()) {
+            profile_sm.SetTimeout(pibConfigs.dwell_time.Read());
         }
+        PIB_LOG_DEBUG_LIMITED("FLA dwell");
         break;
 
     case ST_CONFIRM_MCB_LP:
+        // sent on entry and on each retry
+        if (profile_sm.Entered()) {
+            mcbComm.TX_ASCII(MCB_GO_LOW_POWER);
+        }
+
         if (mcb_low_power) {
             log_nominal("Profile finished, MCB in low power");
             mcb_low_power = false;
+            profile_sm.Dispatch(EV_ACK);
             return true;
-        } else if (CheckAction(RESEND_MCB_LP)) {
-            if (!resend_attempted) {
-                resend_attempted = true;
-                mcbComm.TX_ASCII(MCB_GO_LOW_POWER);
-            } else {
-                resend_attempted = false;
-                ZephyrLogWarn("MCB never powered off after profile");
-                inst_substate = MODE_ERROR; // will force exit of Flight_Profile
-            }
         }
         break;
 
+    case ST_CANCEL_WARMUP:
+        // sent on entry and on each retry
+        if (profile_sm.Entered()) {
+            pu_reset = false;
+            puComm.TX_ASCII(PU_RESET);
+        }
+
+        if (pu_reset) {
+            log_nominal("PU warmup cancelled");
+            profile_sm.Dispatch(EV_ACK);
+        }
+        break;
+
+    case ST_NO_WARMUP:
+        ZephyrLogWarn("PU not responding to warmup command");
+        return true;
+
+    case ST_NO_PROFILE:
+        ZephyrLogWarn("PU not responding to profile command");
+        return true;
+
+    case ST_NO_MOTION:
+        ZephyrLogWarn("MCB never confirmed motion");
+        inst_substate = MODE_ERROR; // will force exit of Flight_Profile
+        return true;
+
+    case ST_NO_MCB_LP:
+        ZephyrLogWarn("MCB never powered off after profile");
+        inst_substate = MODE_ERROR; // will force exit of Flight_Profile
+        return true;
+
+    case ST_DONE:
+    case ST_NO_RA:
     default:
-        // unknown state, exit
+        // finished or unknown state, exit
         return true;
     }
 
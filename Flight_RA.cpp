@@ -0,0 +1,86 @@
+/*
+ *  Flight_RA.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Request permission to move (RA) from the Zephyr. Runs either as a step of
+ *  Flight_Profile or alongside the PU warmup (see SETPARALLELRA).
+ */
+
+#include "StratoPIB.h"
+
+enum RAStates_t : uint8_t {
+    ST_SEND_RA,
+    ST_ACK,
+    ST_NAK,
+    ST_NO_ACK,
+    NUM_RA_STATES
+};
+
+enum RAEvents_t : uint8_t {
+    EV_ACK = SM_EV_USER,
+    EV_NAK,
+};
+
+static constexpr SMStateDef_t ra_states[NUM_RA_STATES] = {
+    /* ST_SEND_RA */ {0, 0, REQ_RA},
+    /* ST_ACK     */ {0, 0},
+    /* ST_NAK     */ {0, 0},
+    /* ST_NO_ACK  */ {0, 0},
+};
+
+static constexpr SMTransition_t ra_transitions[] = {
+    {ST_SEND_RA, EV_ACK,        ST_ACK},
+    {ST_SEND_RA, EV_NAK,        ST_NAK},
+    {ST_SEND_RA, SM_EV_TIMEOUT, ST_NO_ACK},
+};
+
+RAMachine_t::RAMachine_t()
+    : sm(SM_RA, ra_states, NUM_RA_STATES, ra_transitions, SM_TABLE_SIZE(ra_transitions))
+{
+}
+
+bool StratoPIB::Flight_RA(RAMachine_t & machine, bool restart_state)
+{
+    StateMachine & ra_sm = machine.sm;
+
+    if (restart_state) {
+        machine.acked = false;
+        ra_sm.Restart();
+    }
+
+    switch (ra_sm.Run()) {
+    case ST_SEND_RA:
+        // sent on entry and on each retry
+        if (ra_sm.Entered()) {
+            RA_ack_flag = NO_ACK;
+            zephyrTX.RA();
+            log_nominal("Sending RA");
+        }
+
+        PIB_LOG_DEBUG_LIMITED("FLA wait RA Ack");
+        if (ACK == RA_ack_flag) {
+            log_nominal("RA ACK");
+            machine.acked = true;
+            ra_sm.Dispatch(EV_ACK);
+            return true;
+        } else if (NAK == RA_ack_flag) {
+            ZephyrLogWarn("Cannot perform motion, RA NAK");
+            ra_sm.Dispatch(EV_NAK);
+            return true;
+        }
+        break;
+
+    case ST_NO_ACK:
+        ZephyrLogWarn("Never received RAAck");
+        return true;
+
+    case ST_ACK:
+    case ST_NAK:
+    default:
+        // finished or unknown state, exit
+        return true;
+    }
+
+    return false; // assume incomplete
+}
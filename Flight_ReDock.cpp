@@ -6,76 +6,99 @@
 
 #include "StratoPIB.h"
 
-enum ReDockStates_t {
-    ST_ENTRY,
-    ST_IDLE,
+// seconds to let the PU settle after each redock motion
+#define REDOCK_SETTLE_TIME  30
+
+enum ReDockStates_t : uint8_t {
+    ST_REEL_OUT,
     ST_START_MOTION,
-    ST_VERIFY_MOTION,
     ST_MONITOR_MOTION,
-    ST_CHECK_PU,
+    ST_WAIT_IN_NO_LW,
+    ST_IN_NO_LW,
+    ST_WAIT_CHECK_PU,
     ST_WAIT_PU,
+    ST_DONE,
+    ST_NO_MOTION,
+    ST_NO_PU_RESPONSE,
+    NUM_REDOCK_STATES
+};
+
+enum ReDockEvents_t : uint8_t {
+    EV_MOTION_STARTED = SM_EV_USER,
+    EV_OUT_DONE,
+    EV_IN_DONE,
+    EV_MOTION_STOP,
+    EV_DOCKED,
+};
+
+static constexpr SMStateDef_t redock_states[NUM_REDOCK_STATES] = {
+    /* ST_REEL_OUT       */ {0, 0},
+    /* ST_START_MOTION   */ {0, 0, REQ_MCB_MOTION},
+    /* ST_MONITOR_MOTION */ {0, 0},
+    /* ST_WAIT_IN_NO_LW  */ {REDOCK_SETTLE_TIME, 0},
+    /* ST_IN_NO_LW       */ {0, 0},
+    /* ST_WAIT_CHECK_PU  */ {REDOCK_SETTLE_TIME, 0},
+    /* ST_WAIT_PU        */ {0, 0, REQ_PU_STATUS},
+    /* ST_DONE           */ {0, 0},
+    /* ST_NO_MOTION      */ {0, 0},
+    /* ST_NO_PU_RESPONSE */ {0, 0},
+};
+
+static constexpr SMTransition_t redock_transitions[] = {
+    {ST_REEL_OUT,       SM_EV_NEXT,        ST_START_MOTION},
+    {ST_START_MOTION,   EV_MOTION_STARTED, ST_MONITOR_MOTION},
+    {ST_START_MOTION,   SM_EV_TIMEOUT,     ST_NO_MOTION},
+    {ST_MONITOR_MOTION, EV_OUT_DONE,       ST_WAIT_IN_NO_LW},
+    {ST_MONITOR_MOTION, EV_IN_DONE,        ST_WAIT_CHECK_PU},
+    {ST_MONITOR_MOTION, EV_MOTION_STOP,    ST_DONE},
+    {ST_WAIT_IN_NO_LW,  SM_EV_TIMEOUT,     ST_IN_NO_LW},
+    {ST_IN_NO_LW,       SM_EV_NEXT,        ST_START_MOTION},
+    {ST_WAIT_CHECK_PU,  SM_EV_TIMEOUT,     ST_WAIT_PU},
+    {ST_WAIT_PU,        EV_DOCKED,         ST_DONE},
+    {ST_WAIT_PU,        SM_EV_TIMEOUT,     ST_NO_PU_RESPONSE},
 };
 
-static ReDockStates_t redock_state = ST_ENTRY;
-static bool resend_attempted = false;
+ReDockMachine_t::ReDockMachine_t()
+    : sm(SM_REDOCK, redock_states, NUM_REDOCK_STATES, redock_transitions, SM_TABLE_SIZE(redock_transitions))
+{
+}
 
-bool StratoPIB::Flight_ReDock(bool restart_state)
+bool StratoPIB::Flight_ReDock(ReDockMachine_t & machine, bool restart_state)
 {
-    if (restart_state) redock_state = ST_ENTRY;
-
-    switch (redock_state) {
-    case ST_ENTRY:
-        redock_state = ST_IDLE;
-        SetAction(ACTION_REEL_OUT);
-        scheduler.AddAction(ACTION_IN_NO_LW, 30);
-        scheduler.AddAction(ACTION_CHECK_PU, 60);
+    StateMachine & redock_sm = machine.sm;
+
+    if (restart_state) redock_sm.Restart();
+
+    switch (redock_sm.Run()) {
+    case ST_REEL_OUT:
+        mcb_motion = MOTION_REEL_OUT;
+        redock_sm.Dispatch(SM_EV_NEXT);
         break;
 
-    case ST_IDLE:
-        if (CheckAction(ACTION_REEL_OUT)) {
-            redock_state = ST_START_MOTION;
-            mcb_motion = MOTION_REEL_OUT;
-            resend_attempted = false;
-        } else if (CheckAction(ACTION_IN_NO_LW)) {
-            redock_state = ST_START_MOTION;
-            mcb_motion = MOTION_IN_NO_LW;
-            resend_attempted = false;
-        } else if (CheckAction(ACTION_CHECK_PU)) {
-            redock_state = ST_CHECK_PU;
-            resend_attempted = false;
-        }
+    case ST_IN_NO_LW:
+        // reel in what's out, unless the position is unknown
+        retract_length = DockRevs(retract_length, retract_length + deploy_length);
+        mcb_motion = MOTION_IN_NO_LW;
+        redock_sm.Dispatch(SM_EV_NEXT);
         break;
 
     case ST_START_MOTION:
-        if (mcb_motion_ongoing) {
-            ZephyrLogWarn("Motion commanded while motion ongoing");
-            inst_substate = MODE_ERROR; // will force exit of Flight_Profile
-        }
+        // sent on entry and on each retry
+        if (redock_sm.Entered()) {
+            if (mcb_motion_ongoing) {
+                ZephyrLogWarn("Motion commanded while motion ongoing");
+                inst_substate = MODE_ERROR; // will force exit of Flight_Profile
+            }
 
-        if (StartMCBMotion()) {
-            redock_state = ST_VERIFY_MOTION;
-            scheduler.AddAction(RESEND_MOTION_COMMAND, MCB_RESEND_TIMEOUT);
-        } else {
-            ZephyrLogWarn("Motion start error");
-            inst_substate = MODE_ERROR; // will force exit of Flight_Profile
+            if (!StartMCBMotion()) {
+                ZephyrLogWarn("Motion start error");
+                inst_substate = MODE_ERROR; // will force exit of Flight_Profile
+            }
         }
-        break;
 
-    case ST_VERIFY_MOTION:
         if (mcb_motion_ongoing) { // set in the Ack handler
             log_nominal("MCB commanded motion");
-            redock_state = ST_MONITOR_MOTION;
-        }
-
-        if (CheckAction(RESEND_MOTION_COMMAND)) {
-            if (!resend_attempted) {
-                resend_attempted = true;
-                redock_state = ST_START_MOTION;
-            } else {
-                resend_attempted = false;
-                ZephyrLogWarn("MCB never confirmed motion");
-                inst_substate = MODE_ERROR; // will force exit of Flight_Profile
-            }
+            redock_sm.Dispatch(EV_MOTION_STARTED);
         }
         break;
 
@@ -83,44 +106,47 @@ bool StratoPIB::Flight_ReDock(bool restart_state)
         if (CheckAction(ACTION_MOTION_STOP)) {
             // todo: verification of motion stop
             ZephyrLogFine("Commanded motion stop");
+            redock_sm.Dispatch(EV_MOTION_STOP);
             return true;
-            break;
         }
 
         if (!mcb_motion_ongoing) {
-            redock_state = ST_IDLE;
+            redock_sm.Dispatch((MOTION_REEL_OUT == mcb_motion) ? EV_OUT_DONE : EV_IN_DONE);
         }
         break;
 
-    case ST_CHECK_PU:
-        puComm.TX_ASCII(PU_SEND_STATUS);
-        scheduler.AddAction(RESEND_PU_CHECK, PU_RESEND_TIMEOUT);
-        redock_state = ST_WAIT_PU;
+    case ST_WAIT_IN_NO_LW:
+    case ST_WAIT_CHECK_PU:
+        // wait for the state timeout
         break;
 
     case ST_WAIT_PU:
+        // sent on entry and on each retry
+        if (redock_sm.Entered()) {
+            puComm.TX_ASCII(PU_SEND_STATUS);
+        }
+
         if (pibConfigs.pu_docked.Read()) {
             snprintf(log_array, LOG_ARRAY_SIZE, "PU status: %lu, %0.2f, %0.2f, %0.2f, %0.2f, %u", pu_status.time, pu_status.v_battery, pu_status.i_charge, pu_status.therm1, pu_status.therm2, pu_status.heater_stat);
             ZephyrLogFine(log_array);
             mcbComm.TX_ASCII(MCB_ZERO_REEL);
+            redock_sm.Dispatch(EV_DOCKED);
             return true;
-            break;
-        }
-
-        if (CheckAction(RESEND_PU_CHECK)) {
-            if (!resend_attempted) {
-                resend_attempted = true;
-                redock_state = ST_CHECK_PU;
-            } else {
-                resend_attempted = false;
-                ZephyrLogWarn("PU not responding to status request");
-                return true;
-            }
         }
         break;
 
+    case ST_NO_MOTION:
+        ZephyrLogWarn("MCB never confirmed motion");
+        inst_substate = MODE_ERROR; // will force exit of Flight_Profile
+        return true;
+
+    case ST_NO_PU_RESPONSE:
+        ZephyrLogWarn("PU not responding to status request");
+        return true;
+
+    case ST_DONE:
     default:
-        // unknown state, exit
+        // finished or unknown state, exit
         return true;
     }
 
@@ -0,0 +1,138 @@
+/*
+ *  Flight_Retransmit.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Retransmits a range of archived PU records from the SD card (see PUArchive.h)
+ */
+
+#include "StratoPIB.h"
+
+enum RetransmitStates_t : uint8_t {
+    ST_LOCATE,
+    ST_SEND_RECORD,
+    ST_TM_ACK,
+    ST_DONE,
+    NUM_RETRANSMIT_STATES
+};
+
+enum RetransmitEvents_t : uint8_t {
+    EV_SENT = SM_EV_USER,
+    EV_FINISHED,
+    EV_ACK,
+};
+
+static constexpr SMStateDef_t retransmit_states[NUM_RETRANSMIT_STATES] = {
+    /* ST_LOCATE      */ {0, 0},
+    /* ST_SEND_RECORD */ {0, 0},
+    /* ST_TM_ACK      */ {0, 0, REQ_TM},
+    /* ST_DONE        */ {0, 0},
+};
+
+static constexpr SMTransition_t retransmit_transitions[] = {
+    {ST_LOCATE,      SM_EV_NEXT,    ST_SEND_RECORD},
+    {ST_SEND_RECORD, EV_SENT,       ST_TM_ACK},
+    {ST_SEND_RECORD, EV_FINISHED,   ST_DONE},
+    {ST_TM_ACK,      EV_ACK,        ST_SEND_RECORD},
+    {ST_TM_ACK,      SM_EV_TIMEOUT, ST_SEND_RECORD}, // move on without the ack
+};
+
+RetransmitMachine_t::RetransmitMachine_t()
+    : sm(SM_RETRANSMIT, retransmit_states, NUM_RETRANSMIT_STATES, retransmit_transitions, SM_TABLE_SIZE(retransmit_transitions))
+{
+}
+
+bool StratoPIB::Flight_Retransmit(RetransmitMachine_t & machine, bool restart_state)
+{
+    StateMachine & retransmit_sm = machine.sm;
+    uint16_t length = 0;
+    uint16_t found = 0;
+
+    // a profile takes priority in autonomous, the rest of the range can be requested again
+    if (autonomous_mode && CheckAction(ACTION_BEGIN_PROFILE)) {
+        SetAction(ACTION_BEGIN_PROFILE);
+        snprintf(log_array, LOG_ARRAY_SIZE, "Retransmit stopped for profile at packet %u", machine.first_packet + machine.next);
+        ZephyrLogWarn(log_array);
+        machine.active = false;
+        return true;
+    }
+
+    if (restart_state) {
+        machine.next = 0;
+        machine.sent = 0;
+        machine.missing = 0;
+        machine.pending = false;
+        machine.active = true;
+        retransmit_sm.Restart();
+    }
+
+    switch (retransmit_sm.Run()) {
+    case ST_LOCATE:
+        // one pass over the index for the whole range
+        found = puArchive.Locate(machine.night, machine.profile, machine.first_packet, machine.count, machine.locations);
+        snprintf(log_array, LOG_ARRAY_SIZE, "Located %u of %u archived records", found, machine.count);
+        log_nominal(log_array);
+        retransmit_sm.Dispatch(SM_EV_NEXT);
+        break;
+
+    case ST_SEND_RECORD:
+        if (machine.next >= machine.count) {
+            retransmit_sm.Dispatch(EV_FINISHED);
+            break;
+        }
+
+        // the PU RX buffer is free while no offload is running
+        length = puArchive.ReadAt(machine.night, machine.profile, machine.first_packet + machine.next,
+                                  machine.locations[machine.next], binary_pu, PU_BUFFER_SIZE);
+        machine.next++;
+
+        if (0 == length) {
+            machine.missing++;
+            break; // try the next one on the next loop
+        }
+
+        zephyrTX.clearTm();
+        if (!AddPURecordTM(binary_pu, length)) {
+            log_error("Unable to add archived record to TM buffer");
+            machine.missing++;
+            break;
+        }
+
+        snprintf(log_array, LOG_ARRAY_SIZE, "PU Archive Record: night %u, profile %u, packet %u", machine.night, machine.profile, machine.first_packet + machine.next - 1);
+        zephyrTX.setStateDetails(1, log_array);
+        zephyrTX.setStateFlagValue(1, FINE);
+        zephyrTX.setStateFlagValue(2, NOMESS);
+        zephyrTX.setStateFlagValue(3, NOMESS);
+
+        TM_ack_flag = NO_ACK;
+        zephyrTX.TM();
+        machine.sent++;
+        retransmit_sm.Dispatch(EV_SENT);
+        break;
+
+    case ST_TM_ACK:
+        // the TM is sent with the record, resend on each retry
+        if (retransmit_sm.Entered() && 0 != retransmit_sm.RetryCount()) {
+            log_error("Needed to resend TM");
+            TM_ack_flag = NO_ACK;
+            zephyrTX.TM(); // message is still saved in XMLWriter, no need to reconstruct
+        }
+
+        if (ACK == TM_ack_flag) {
+            retransmit_sm.Dispatch(EV_ACK);
+        } else if (NAK == TM_ack_flag) {
+            TM_ack_flag = NO_ACK;
+            retransmit_sm.Retry();
+        }
+        break;
+
+    case ST_DONE:
+    default:
+        snprintf(log_array, LOG_ARRAY_SIZE, "Retransmitted %u archived records, %u missing", machine.sent, machine.missing);
+        ZephyrLogFine(log_array);
+        machine.active = false;
+        return true;
+    }
+
+    return false; // assume incomplete
+}
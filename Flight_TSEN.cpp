@@ -6,19 +6,47 @@
 
 #include "StratoPIB.h"
 
-enum TSENStates_t {
-    ST_ENTRY,
+enum TSENStates_t : uint8_t {
     ST_GET_PU_STATUS,
-    ST_REQUEST_TSEN,
     ST_WAIT_TSEN,
     ST_TM_ACK,
+    ST_DONE,
+    ST_NO_TSEN,
+    NUM_TSEN_STATES
 };
 
-static TSENStates_t tsen_state = ST_ENTRY;
-static bool resend_attempted = false;
+enum TSENEvents_t : uint8_t {
+    EV_TSEN = SM_EV_USER,
+    EV_NO_MORE_RECORDS,
+    EV_ACK,
+};
+
+static constexpr SMStateDef_t tsen_states[NUM_TSEN_STATES] = {
+    /* ST_GET_PU_STATUS */ {0, 0},
+    /* ST_WAIT_TSEN     */ {0, 0, REQ_PU_TSEN},
+    /* ST_TM_ACK        */ {0, 0, REQ_TM},
+    /* ST_DONE          */ {0, 0},
+    /* ST_NO_TSEN       */ {0, 0},
+};
+
+static constexpr SMTransition_t tsen_transitions[] = {
+    {ST_GET_PU_STATUS, SM_EV_NEXT,         ST_WAIT_TSEN},
+    {ST_WAIT_TSEN,     EV_TSEN,            ST_TM_ACK},
+    {ST_WAIT_TSEN,     EV_NO_MORE_RECORDS, ST_DONE},
+    {ST_WAIT_TSEN,     SM_EV_TIMEOUT,      ST_NO_TSEN},
+    {ST_TM_ACK,        EV_ACK,             ST_GET_PU_STATUS},
+    {ST_TM_ACK,        SM_EV_TIMEOUT,      ST_GET_PU_STATUS}, // move on without the ack
+};
+
+TSENMachine_t::TSENMachine_t()
+    : sm(SM_TSEN, tsen_states, NUM_TSEN_STATES, tsen_transitions, SM_TABLE_SIZE(tsen_transitions))
+{
+}
 
-bool StratoPIB::Flight_TSEN(bool restart_state)
+bool StratoPIB::Flight_TSEN(TSENMachine_t & machine, bool restart_state)
 {
+    StateMachine & tsen_sm = machine.sm;
+
     // TSEN is overrideable in manual mode if a command is received, or autonomous if it's profile time
     if (!autonomous_mode && CheckAction(ACTION_OVERRIDE_TSEN)) {
         return true; // kill the TSEN state
@@ -27,69 +55,62 @@ bool StratoPIB::Flight_TSEN(bool restart_state)
         return true;
     }
 
-    if (restart_state) tsen_state = ST_ENTRY;
-
-    switch (tsen_state) {
-    case ST_ENTRY:
-        resend_attempted = false;
-        Flight_CheckPU(true);
-        tsen_state = ST_GET_PU_STATUS;
-        break;
+    if (restart_state) tsen_sm.Restart();
 
+    switch (tsen_sm.Run()) {
     case ST_GET_PU_STATUS:
-        if (Flight_CheckPU(false)) {
-            tsen_state = ST_REQUEST_TSEN;
+        if (Flight_CheckPU(machine.check_pu, tsen_sm.Entered())) {
+            tsen_sm.Dispatch(SM_EV_NEXT);
         }
         break;
 
-    case ST_REQUEST_TSEN:
-        puComm.TX_ASCII(PU_SEND_TSEN_RECORD);
-        scheduler.AddAction(RESEND_PU_TSEN, PU_RESEND_TIMEOUT);
-        tsen_received = false;
-        pu_no_more_records = false;
-        tsen_state = ST_WAIT_TSEN;
-        break;
-
     case ST_WAIT_TSEN:
+        // sent on entry and on each retry
+        if (tsen_sm.Entered()) {
+            puComm.TX_ASCII(PU_SEND_TSEN_RECORD);
+            tsen_received = false;
+            pu_no_more_records = false;
+        }
+
         if (tsen_received) { // ACK/NAK in PURouter
             tsen_received = false;
-            snprintf(log_array, LOG_ARRAY_SIZE, "Received TSEN: %u", puComm.binary_rx.bin_length);
-            log_nominal(log_array);
+            binaryLog.Log(BL_TSEN_RECEIVED, puComm.binary_rx.bin_length);
+            RollArchiveNight();
+            pibConfigs.archive_tsen.Write(pibConfigs.archive_tsen.Read() + 1);
+            ArchivePURecord(PU_ARCHIVE_TSEN, pibConfigs.archive_tsen.Read());
             SendTSENTM();
-            tsen_state = ST_TM_ACK;
-            scheduler.AddAction(RESEND_TM, ZEPHYR_RESEND_TIMEOUT);
-            break;
+            tsen_sm.Dispatch(EV_TSEN);
         } else if (pu_no_more_records) {
             pu_no_more_records = false;
             log_nominal("No more TSEN records");
+            tsen_sm.Dispatch(EV_NO_MORE_RECORDS);
             return true;
         }
-
-        if (CheckAction(RESEND_PU_TSEN)) {
-            if (!resend_attempted) {
-                resend_attempted = true;
-                tsen_state = ST_REQUEST_TSEN;
-            } else {
-                resend_attempted = false;
-                ZephyrLogWarn("PU not successful in sending TSEN");
-                return true;
-            }
-        }
         break;
 
     case ST_TM_ACK:
-        if (ACK == TM_ack_flag) {
-            tsen_state = ST_ENTRY;
-        } else if (NAK == TM_ack_flag || CheckAction(RESEND_TM)) {
-            // attempt one resend
+        // the TM is sent with the record, resend on each retry
+        if (tsen_sm.Entered() && 0 != tsen_sm.RetryCount()) {
             log_error("Needed to resend TM");
+            TM_ack_flag = NO_ACK;
             zephyrTX.TM(); // message is still saved in XMLWriter, no need to reconstruct
-            tsen_state = ST_ENTRY;
+        }
+
+        if (ACK == TM_ack_flag) {
+            tsen_sm.Dispatch(EV_ACK);
+        } else if (NAK == TM_ack_flag) {
+            TM_ack_flag = NO_ACK;
+            tsen_sm.Retry();
         }
         break;
 
+    case ST_NO_TSEN:
+        ZephyrLogWarn("PU not successful in sending TSEN");
+        return true;
+
+    case ST_DONE:
     default:
-        // unknown state, exit
+        // finished or unknown state, exit
         return true;
     }
 
@@ -36,7 +36,7 @@ void StratoPIB::LowPowerMode()
         inst_substate = LP_CHECK_MCB;
         break;
     case LP_CHECK_MCB:
-        log_debug("Waiting on MCB LP ack");
+        PIB_LOG_DEBUG_LIMITED("Waiting on MCB LP ack");
         if (mcb_low_power) {
             mcb_low_power = false;
             inst_substate = LP_LOOP;
@@ -46,10 +46,10 @@ void StratoPIB::LowPowerMode()
         break;
     case LP_LOOP:
         // nominal ops
-        log_debug("LP loop");
+        PIB_LOG_DEBUG_LIMITED("LP loop");
         break;
     case LP_ERROR_LANDING:
-        log_debug("LP error");
+        PIB_LOG_DEBUG_LIMITED("LP error");
         break;
     case LP_SHUTDOWN:
         // prep for shutdown
@@ -37,12 +37,18 @@ void StratoPIB::HandleMCBASCII()
         CheckAction(ACTION_MOTION_TIMEOUT); // clear the timeout
         log_nominal("MCB motion finished"); // state machine will report to Zephyr
         mcb_motion_ongoing = false;
+        reelTracker.MotionEnded(true);
+        SaveReelPosition();
         break;
     case MCB_MOTION_FAULT:
         CheckAction(ACTION_MOTION_TIMEOUT); // clear the timeout
         // if flag already cleared, assume this is the repeat
         if (!mcb_motion_ongoing) return;
 
+        // the position from the last TM frame stands
+        reelTracker.MotionEnded(false);
+        SaveReelPosition();
+
         if (mcbComm.RX_Motion_Fault(motion_fault, motion_fault+1, motion_fault+2, motion_fault+3,
                                     motion_fault+4, motion_fault+5, motion_fault+6, motion_fault+7)) {
             // expected if docking
@@ -82,19 +88,24 @@ void StratoPIB::HandleMCBAck()
 {
     switch (mcbComm.ack_id) {
     case MCB_GO_LOW_POWER:
+        ReliableRequest::AckReceived(REQ_MCB_LOW_POWER);
         log_nominal("MCB in low power");
         mcb_low_power = true;
         break;
     case MCB_REEL_IN:
+        ReliableRequest::AckReceived(REQ_MCB_MOTION);
         if (MOTION_REEL_IN == mcb_motion) NoteProfileStart();
         break;
     case MCB_REEL_OUT:
+        ReliableRequest::AckReceived(REQ_MCB_MOTION);
         if (MOTION_REEL_OUT == mcb_motion) NoteProfileStart();
         break;
     case MCB_DOCK:
+        ReliableRequest::AckReceived(REQ_MCB_MOTION);
         if (MOTION_DOCK == mcb_motion) NoteProfileStart();
         break;
     case MCB_IN_NO_LW:
+        ReliableRequest::AckReceived(REQ_MCB_MOTION);
         if (MOTION_IN_NO_LW == mcb_motion) NoteProfileStart();
         break;
     case MCB_FULL_RETRACT:
@@ -110,6 +121,8 @@ void StratoPIB::HandleMCBAck()
         ZephyrLogFine("MCB acked dock acc");
         break;
     case MCB_ZERO_REEL:
+        reelTracker.Zero();
+        SaveReelPosition();
         ZephyrLogFine("MCB acked zero reel");
         break;
     case MCB_TEMP_LIMITS:
@@ -136,16 +149,17 @@ void StratoPIB::HandleMCBAck()
 void StratoPIB::HandleMCBBin()
 {
     float reel_pos = 0;
-    uint16_t reel_pos_index = 21; // todo: don't hard-code this
+    uint16_t reel_pos_index = MOTION_TM_POSITION_INDEX;
 
     switch (mcbComm.binary_rx.bin_id) {
     case MCB_MOTION_TM:
         if (BufferGetFloat(&reel_pos, mcbComm.binary_rx.bin_buffer, mcbComm.binary_rx.bin_length, &reel_pos_index)) {
-            snprintf(log_array, 101, "Reel position: %ld", (int32_t) reel_pos);
-            log_nominal(log_array);
+            reelTracker.Update(millis(), reel_pos);
+            binaryLog.Log(BL_REEL_POSITION, (int32_t) reel_pos);
         } else {
-            log_nominal("Recieved MCB bin: unable to read position");
+            binaryLog.Log(BL_REEL_POSITION_ERR);
         }
+        AnalyzeMotionTM();
         AddMCBTM();
         break;
     case MCB_EEPROM:
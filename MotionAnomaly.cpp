@@ -0,0 +1,96 @@
+/*
+ *  MotionAnomaly.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Online anomaly detection over the MCB motion TM
+ */
+
+#include "MotionAnomaly.h"
+
+void MotionAnomaly::Reset(bool check_slopes)
+{
+    tripped = ANOMALY_NONE;
+    value = 0.0f;
+    limit = 0.0f;
+    slopes = check_slopes;
+    next = 0;
+    frames = 0;
+    cusum = 0.0f;
+}
+
+MotionAnomaly_t MotionAnomaly::Add(uint32_t time_ms, float current, float torque, float temp)
+{
+    float slope = 0.0f;
+
+    if (ANOMALY_NONE != tripped) return ANOMALY_NONE;
+
+    if (0 == frames) {
+        first_ms = time_ms;
+        last_ms = time_ms;
+        temp_start = temp;
+    }
+
+    times[next] = (time_ms - first_ms) / 1000.0f;
+    torques[next] = torque;
+    currents[next] = current;
+    next = (next + 1) % ANOMALY_WINDOW;
+    if (frames < UINT16_MAX) frames++;
+
+    // temperature rise CUSUM, weighted by the time since the last frame
+    cusum += (temp - temp_start - limits.temp_slack) * ((time_ms - last_ms) / 1000.0f);
+    if (cusum < 0.0f) cusum = 0.0f;
+    last_ms = time_ms;
+
+    if (limits.temp_cusum > 0.0f && cusum > limits.temp_cusum) {
+        return Trip(ANOMALY_TEMP_CUSUM, cusum, limits.temp_cusum);
+    }
+
+    if (!slopes || frames < ANOMALY_WINDOW) return ANOMALY_NONE;
+
+    slope = Slope(torques);
+    if (limits.torque_slope > 0.0f && slope > limits.torque_slope) {
+        return Trip(ANOMALY_TORQUE_SLOPE, slope, limits.torque_slope);
+    }
+
+    slope = Slope(currents);
+    if (limits.current_slope > 0.0f && slope > limits.current_slope) {
+        return Trip(ANOMALY_CURRENT_SLOPE, slope, limits.current_slope);
+    }
+
+    return ANOMALY_NONE;
+}
+
+float MotionAnomaly::Slope(const float * values)
+{
+    float mean_t = 0.0f;
+    float mean_v = 0.0f;
+    float covariance = 0.0f;
+    float variance = 0.0f;
+
+    for (int i = 0; i < ANOMALY_WINDOW; i++) {
+        mean_t += times[i];
+        mean_v += values[i];
+    }
+    mean_t /= ANOMALY_WINDOW;
+    mean_v /= ANOMALY_WINDOW;
+
+    for (int i = 0; i < ANOMALY_WINDOW; i++) {
+        covariance += (times[i] - mean_t) * (values[i] - mean_v);
+        variance += (times[i] - mean_t) * (times[i] - mean_t);
+    }
+
+    // frames too close together to fit
+    if (variance <= 0.0f) return 0.0f;
+
+    return covariance / variance;
+}
+
+MotionAnomaly_t MotionAnomaly::Trip(MotionAnomaly_t anomaly, float statistic, float statistic_limit)
+{
+    tripped = anomaly;
+    value = statistic;
+    limit = statistic_limit;
+
+    return anomaly;
+}
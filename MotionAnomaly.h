@@ -0,0 +1,84 @@
+/*
+ *  MotionAnomaly.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Online anomaly detection over the MCB motion TM, to cancel a motion on a
+ *  developing problem well before the motion timeout or an MCB hard fault:
+ *    - least-squares slope of the motor torque and current over the last
+ *      ANOMALY_WINDOW frames, tripping above a limit (per second)
+ *    - a one-sided CUSUM of the motor temperature rise above its value at the
+ *      start of the motion, less a slack, tripping above a limit (deg C * s)
+ *
+ *  The torque, current, and temperature come from the frame at the MotionTM.h
+ *  offsets, so the checks only build against a layout that matches the MCB's
+ *  MOTION_TM_SIZE. A limit of zero disables that check. The slope checks are skipped for
+ *  docking motions, which end on a torque limit by design. Once tripped, the
+ *  detector stays tripped until the next motion.
+ *
+ *  No Arduino dependencies.
+ */
+
+#ifndef MOTIONANOMALY_H
+#define MOTIONANOMALY_H
+
+#include <stdint.h>
+
+#define ANOMALY_WINDOW  8 // frames in the slope fit
+
+enum MotionAnomaly_t : uint8_t {
+    ANOMALY_NONE,
+    ANOMALY_TORQUE_SLOPE,
+    ANOMALY_CURRENT_SLOPE,
+    ANOMALY_TEMP_CUSUM
+};
+
+struct AnomalyLimits_t {
+    float torque_slope;  // torque units per second
+    float current_slope; // A per second
+    float temp_slack;    // deg C of rise allowed before accumulating
+    float temp_cusum;    // deg C * s
+};
+
+class MotionAnomaly {
+public:
+    MotionAnomaly() { };
+    ~MotionAnomaly() { };
+
+    void Configure(AnomalyLimits_t new_limits) { limits = new_limits; }
+
+    // start of a motion, check_slopes = false for docking
+    void Reset(bool check_slopes);
+
+    // one decoded motion TM frame, returns the anomaly if this frame tripped the detector
+    MotionAnomaly_t Add(uint32_t time_ms, float current, float torque, float temp);
+
+    MotionAnomaly_t Tripped() { return tripped; }
+    float Value() { return value; } // the statistic that tripped
+    float Limit() { return limit; } // and its limit
+
+private:
+    float Slope(const float * values);
+    MotionAnomaly_t Trip(MotionAnomaly_t anomaly, float statistic, float statistic_limit);
+
+    AnomalyLimits_t limits = {};
+    MotionAnomaly_t tripped = ANOMALY_NONE;
+    float value = 0.0f;
+    float limit = 0.0f;
+    bool slopes = true;
+
+    // slope window (seconds from the motion's first frame)
+    float times[ANOMALY_WINDOW] = {0};
+    float torques[ANOMALY_WINDOW] = {0};
+    float currents[ANOMALY_WINDOW] = {0};
+    uint8_t next = 0;
+    uint16_t frames = 0;
+    uint32_t first_ms = 0;
+
+    // temperature CUSUM
+    float temp_start = 0.0f;
+    float cusum = 0.0f;
+    uint32_t last_ms = 0;
+};
+
+#endif /* MOTIONANOMALY_H */
@@ -0,0 +1,213 @@
+/*
+ *  MotionCodec.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Keyframe and delta/zigzag varint coding of MCB motion TM frames
+ */
+
+#include "MotionCodec.h"
+
+enum FieldPrediction_t : uint8_t {
+    PREDICT_LAST,
+    PREDICT_LINEAR
+};
+
+struct FieldLayout_t {
+    uint8_t size; // bytes, 0 for the time
+    FieldPrediction_t prediction;
+};
+
+// the time, then the frame fields in the MotionTM.h order
+static constexpr FieldLayout_t layout[MOTION_CODEC_FIELDS] = {
+    {0, PREDICT_LINEAR}, // tenths of seconds since the motion start (u16)
+    {1, PREDICT_LAST},   // status byte
+    {4, PREDICT_LAST},   // MOTION_TM_TORQUE
+    {4, PREDICT_LAST},   // MOTION_TM_CURRENT
+    {4, PREDICT_LAST},   // MOTION_TM_TEMP
+    {4, PREDICT_LAST},   // MOTION_TM_SPEED
+    {4, PREDICT_LAST},   // MOTION_TM_AUX
+    {4, PREDICT_LINEAR}, // MOTION_TM_REEL_POSITION
+};
+
+static constexpr uint16_t LayoutBytes(uint8_t field)
+{
+    return (field >= MOTION_CODEC_FIELDS) ? 0 : layout[field].size + LayoutBytes(field + 1);
+}
+
+static_assert(MOTION_FRAME_SIZE == LayoutBytes(1), "MotionCodec layout must cover the MotionTM.h frame");
+static_assert(MOTION_TM_STATUS_INDEX == 0 && 1 == layout[1].size, "MotionCodec expects the status byte first");
+static_assert(PREDICT_LINEAR == layout[MOTION_CODEC_FLOAT(MOTION_TM_REEL_POSITION)].prediction,
+              "MotionCodec extrapolates the reel position");
+
+static uint8_t FieldBytes(uint8_t field)
+{
+    return (0 == layout[field].size) ? 2 : layout[field].size;
+}
+
+static uint32_t FieldMask(uint8_t field)
+{
+    return (4 == FieldBytes(field)) ? 0xFFFFFFFF : (((uint32_t) 1 << (8 * FieldBytes(field))) - 1);
+}
+
+// residual modulo the field width, as a signed value
+static int32_t SignExtend(uint32_t value, uint8_t field)
+{
+    uint32_t mask = FieldMask(field);
+
+    value &= mask;
+    if (value & ((mask >> 1) + 1)) value |= ~mask;
+
+    return (int32_t) value;
+}
+
+static uint8_t PutVarint(uint32_t value, uint8_t * out, uint8_t out_size)
+{
+    uint8_t used = 0;
+
+    do {
+        if (used == out_size) return 0;
+        out[used++] = (uint8_t) ((value & 0x7F) | ((value > 0x7F) ? 0x80 : 0x00));
+        value >>= 7;
+    } while (0 != value);
+
+    return used;
+}
+
+static uint8_t GetVarint(const uint8_t * buffer, uint16_t length, uint32_t * value)
+{
+    uint8_t used = 0;
+
+    *value = 0;
+
+    while (used < length && used < 5) {
+        *value |= (uint32_t) (buffer[used] & 0x7F) << (7 * used);
+        if (0 == (buffer[used++] & 0x80)) return used;
+    }
+
+    return 0; // truncated or too long
+}
+
+void MotionPredictor::Split(const uint8_t * frame, uint16_t tenths, uint32_t * values)
+{
+    uint8_t index = 0;
+
+    values[0] = tenths;
+
+    for (int field = 1; field < MOTION_CODEC_FIELDS; field++) {
+        values[field] = 0;
+        for (int i = layout[field].size - 1; i >= 0; i--) {
+            values[field] = (values[field] << 8) | frame[index + i];
+        }
+        index += layout[field].size;
+    }
+}
+
+void MotionPredictor::Join(const uint32_t * values, uint8_t * frame, uint16_t * tenths)
+{
+    uint8_t index = 0;
+
+    *tenths = (uint16_t) values[0];
+
+    for (int field = 1; field < MOTION_CODEC_FIELDS; field++) {
+        for (int i = 0; i < layout[field].size; i++) {
+            frame[index++] = (uint8_t) (values[field] >> (8 * i));
+        }
+    }
+}
+
+uint32_t MotionPredictor::Predict(uint8_t field)
+{
+    if (PREDICT_LINEAR == layout[field].prediction && frames >= 2) {
+        return (2 * last[field] - previous[field]) & FieldMask(field);
+    }
+
+    return last[field];
+}
+
+void MotionPredictor::Update(const uint32_t * values)
+{
+    for (int field = 0; field < MOTION_CODEC_FIELDS; field++) {
+        previous[field] = last[field];
+        last[field] = values[field];
+    }
+
+    if (frames < UINT16_MAX) frames++;
+}
+
+uint8_t MotionEncoder::Encode(const uint8_t * frame, uint16_t tenths, uint8_t * out, uint8_t out_size)
+{
+    uint32_t values[MOTION_CODEC_FIELDS] = {0};
+    uint8_t used = 0;
+
+    MotionPredictor::Split(frame, tenths, values);
+
+    if (predictor.Keyframe()) {
+        if (out_size < 3 + MOTION_FRAME_SIZE) return 0;
+
+        out[used++] = MOTION_KEYFRAME_SYNC;
+        out[used++] = (uint8_t) tenths;
+        out[used++] = (uint8_t) (tenths >> 8);
+        for (int i = 0; i < MOTION_FRAME_SIZE; i++) {
+            out[used++] = frame[i];
+        }
+    } else {
+        if (out_size < 1) return 0;
+        out[used++] = MOTION_DELTA_SYNC;
+
+        for (int field = 0; field < MOTION_CODEC_FIELDS; field++) {
+            int32_t residual = SignExtend(values[field] - predictor.Predict(field), field);
+            uint32_t zigzag = ((uint32_t) residual << 1) ^ (uint32_t) (residual >> 31);
+            uint8_t varint = PutVarint(zigzag, out + used, out_size - used);
+
+            if (0 == varint) return 0;
+            used += varint;
+        }
+    }
+
+    predictor.Update(values);
+
+    return used;
+}
+
+uint16_t MotionDecoder::Decode(const uint8_t * buffer, uint16_t length, uint8_t * frame, uint16_t * tenths)
+{
+    uint32_t values[MOTION_CODEC_FIELDS] = {0};
+    uint16_t used = 0;
+
+    if (0 == length) return 0;
+
+    if (MOTION_KEYFRAME_SYNC == buffer[0]) {
+        if (length < 3 + MOTION_FRAME_SIZE) return 0;
+
+        predictor.Reset();
+        *tenths = (uint16_t) (buffer[1] | (buffer[2] << 8));
+        for (int i = 0; i < MOTION_FRAME_SIZE; i++) {
+            frame[i] = buffer[3 + i];
+        }
+
+        MotionPredictor::Split(frame, *tenths, values);
+        predictor.Update(values);
+
+        return 3 + MOTION_FRAME_SIZE;
+    }
+
+    if (MOTION_DELTA_SYNC != buffer[0] || predictor.Keyframe()) return 0;
+    used = 1;
+
+    for (int field = 0; field < MOTION_CODEC_FIELDS; field++) {
+        uint32_t zigzag = 0;
+        uint8_t varint = GetVarint(buffer + used, length - used, &zigzag);
+        uint32_t residual = (zigzag >> 1) ^ (0 - (zigzag & 1));
+
+        if (0 == varint) return 0;
+        used += varint;
+
+        values[field] = (predictor.Predict(field) + residual) & FieldMask(field);
+    }
+
+    MotionPredictor::Join(values, frame, tenths);
+    predictor.Update(values);
+
+    return used;
+}
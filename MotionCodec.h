@@ -0,0 +1,82 @@
+/*
+ *  MotionCodec.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Lossless compression of buffered MCB motion TM frames. The first frame of
+ *  each TM segment is sent whole as a keyframe, and each following frame as
+ *  the zigzag varint residuals of its fields against a prediction from the
+ *  previous frames: the last value, or a linear extrapolation for ramping
+ *  fields like the time and reel position. Floats are predicted as their
+ *  integer bit patterns, which is lossless and small for slowly varying
+ *  values of the same sign.
+ *
+ *    keyframe:    0xA7, tenths of seconds (u16), the raw frame
+ *    delta frame: 0xA8, a varint residual for the time and each field
+ *
+ *  The decoder is in this file too. This file has no Arduino dependencies so
+ *  that it can be compiled into ground software.
+ */
+
+#ifndef MOTIONCODEC_H
+#define MOTIONCODEC_H
+
+#include "MotionTM.h"
+#include <stdint.h>
+
+#define MOTION_FRAME_SIZE       MOTION_TM_FRAME_SIZE
+#define MOTION_KEYFRAME_SYNC    0xA7
+#define MOTION_DELTA_SYNC       0xA8
+#define MOTION_RECORD_MAX       40   // bytes, the largest keyframe or delta frame
+
+// the time, the status byte, and each float of the frame are coded separately
+#define MOTION_CODEC_FIELDS     (2 + NUM_MOTION_TM_FLOATS)
+#define MOTION_CODEC_FLOAT(field)   (2 + (field))
+
+// prediction state shared by the encoder and decoder
+class MotionPredictor {
+public:
+    void Reset() { frames = 0; }
+
+    // unpack the time and frame into field values
+    static void Split(const uint8_t * frame, uint16_t tenths, uint32_t * values);
+    static void Join(const uint32_t * values, uint8_t * frame, uint16_t * tenths);
+
+    uint32_t Predict(uint8_t field);
+    void Update(const uint32_t * values);
+
+    bool Keyframe() { return 0 == frames; }
+
+private:
+    uint32_t last[MOTION_CODEC_FIELDS] = {0};
+    uint32_t previous[MOTION_CODEC_FIELDS] = {0};
+    uint16_t frames = 0;
+};
+
+class MotionEncoder {
+public:
+    // start of a segment, the next frame is a keyframe
+    void Reset() { predictor.Reset(); }
+
+    // returns the bytes written to out, or 0 if out_size is too small
+    uint8_t Encode(const uint8_t * frame, uint16_t tenths, uint8_t * out, uint8_t out_size);
+
+private:
+    MotionPredictor predictor;
+};
+
+class MotionDecoder {
+public:
+    // start of a segment
+    void Reset() { predictor.Reset(); }
+
+    // Decode the record at the start of buffer into a MOTION_FRAME_SIZE frame and its
+    // time. Returns the bytes consumed, or 0 if the record is truncated, has an
+    // unknown sync byte, or is a delta frame without a keyframe.
+    uint16_t Decode(const uint8_t * buffer, uint16_t length, uint8_t * frame, uint16_t * tenths);
+
+private:
+    MotionPredictor predictor;
+};
+
+#endif /* MOTIONCODEC_H */
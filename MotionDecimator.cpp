@@ -0,0 +1,40 @@
+/*
+ *  MotionDecimator.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Min/max/mean decimation of MCB motion TM frames
+ */
+
+#include "MotionDecimator.h"
+
+void MotionDecimator::Reset()
+{
+    count = 0;
+}
+
+void MotionDecimator::Add(uint16_t tenths, const float * values)
+{
+    if (0 == count) first_tenths = tenths;
+    last_tenths = tenths;
+
+    for (int i = 0; i < MOTION_DECIMATE_FIELDS; i++) {
+        if (0 == count || values[i] < min[i]) min[i] = values[i];
+        if (0 == count || values[i] > max[i]) max[i] = values[i];
+        total[i] = (0 == count) ? values[i] : total[i] + values[i];
+    }
+
+    if (count < UINT16_MAX) count++;
+}
+
+void MotionDecimator::Summary(uint8_t field, float * out)
+{
+    if (field >= MOTION_DECIMATE_FIELDS || 0 == count) {
+        out[0] = out[1] = out[2] = 0.0f;
+        return;
+    }
+
+    out[0] = min[field];
+    out[1] = max[field];
+    out[2] = total[field] / count;
+}
@@ -0,0 +1,46 @@
+/*
+ *  MotionDecimator.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Reduces a window of MCB motion TM frames to the min, max, and mean of each
+ *  float field for the decimated real-time MCB TM mode.
+ *
+ *  No Arduino dependencies.
+ */
+
+#ifndef MOTIONDECIMATOR_H
+#define MOTIONDECIMATOR_H
+
+#include "MotionTM.h"
+#include <stdint.h>
+
+// every float of the motion TM frame, in the MotionTM.h order
+#define MOTION_DECIMATE_FIELDS  NUM_MOTION_TM_FLOATS
+#define MOTION_DECIMATE_INDEX   MOTION_TM_FLOAT_INDEX
+
+class MotionDecimator {
+public:
+    MotionDecimator() { };
+    ~MotionDecimator() { };
+
+    void Reset();
+    void Add(uint16_t tenths, const float * values);
+
+    uint16_t Count() { return count; }
+    uint16_t FirstTenths() { return first_tenths; }
+    uint16_t LastTenths() { return last_tenths; }
+
+    // min, max, and mean of the field over the window
+    void Summary(uint8_t field, float * out);
+
+private:
+    float min[MOTION_DECIMATE_FIELDS] = {0};
+    float max[MOTION_DECIMATE_FIELDS] = {0};
+    float total[MOTION_DECIMATE_FIELDS] = {0};
+    uint16_t count = 0;
+    uint16_t first_tenths = 0;
+    uint16_t last_tenths = 0;
+};
+
+#endif /* MOTIONDECIMATOR_H */
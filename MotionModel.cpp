@@ -0,0 +1,25 @@
+/*
+ *  MotionModel.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Expected reel motion durations from a trapezoidal velocity profile
+ */
+
+#include "MotionModel.h"
+#include <math.h>
+
+float MotionSeconds(float revs, float velocity, float acceleration)
+{
+    float v = velocity / 60.0f;     // rev/s
+    float a = acceleration / 60.0f; // rev/s^2
+
+    if (revs <= 0.0f || v <= 0.0f) return 0.0f;
+
+    if (a <= 0.0f) return revs / v;
+
+    // triangular if the ramps up and down would cover the whole move
+    if (v * v / a >= revs) return 2.0f * sqrtf(revs / a);
+
+    return revs / v + v / a;
+}
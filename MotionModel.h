@@ -0,0 +1,21 @@
+/*
+ *  MotionModel.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Expected reel motion durations from a trapezoidal velocity profile: the
+ *  MCB accelerates at the commanded acceleration up to the commanded velocity,
+ *  cruises, and decelerates at the same rate. Moves too short to reach the
+ *  velocity are triangular. Without a known acceleration, the move is modeled
+ *  at constant velocity as before.
+ *
+ *  No Arduino dependencies.
+ */
+
+#ifndef MOTIONMODEL_H
+#define MOTIONMODEL_H
+
+// seconds to move revs at velocity (rpm) with acceleration (rpm/s, <= 0 if unknown)
+float MotionSeconds(float revs, float velocity, float acceleration);
+
+#endif /* MOTIONMODEL_H */
@@ -0,0 +1,172 @@
+/*
+ *  MotionStats.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Streaming statistics over the MCB motion TM
+ */
+
+#include "MotionStats.h"
+#include <math.h>
+
+void RunningStats::Reset()
+{
+    count = 0;
+    mean = 0.0f;
+    m2 = 0.0f;
+    min = 0.0f;
+    max = 0.0f;
+}
+
+void RunningStats::Add(float x)
+{
+    float delta = 0.0f;
+
+    if (0 == count || x < min) min = x;
+    if (0 == count || x > max) max = x;
+
+    count++;
+    delta = x - mean;
+    mean += delta / count;
+    m2 += delta * (x - mean);
+}
+
+float RunningStats::StdDev()
+{
+    if (count < 2) return 0.0f;
+
+    return sqrtf(m2 / (count - 1));
+}
+
+void P2Quantile::Add(float x)
+{
+    int k = 0;
+
+    // collect the first five samples as the initial markers
+    if (count < 5) {
+        q[count++] = x;
+
+        if (5 == count) {
+            // insertion sort
+            for (int i = 1; i < 5; i++) {
+                float temp = q[i];
+                int j = i - 1;
+                while (j >= 0 && q[j] > temp) {
+                    q[j+1] = q[j];
+                    j--;
+                }
+                q[j+1] = temp;
+            }
+
+            for (int i = 0; i < 5; i++) n[i] = i;
+            desired[0] = 0.0f;
+            desired[1] = 2.0f * p;
+            desired[2] = 4.0f * p;
+            desired[3] = 2.0f + 2.0f * p;
+            desired[4] = 4.0f;
+            increment[0] = 0.0f;
+            increment[1] = p / 2.0f;
+            increment[2] = p;
+            increment[3] = (1.0f + p) / 2.0f;
+            increment[4] = 1.0f;
+        }
+        return;
+    }
+
+    // find the cell containing the sample, extending the extremes
+    if (x < q[0]) {
+        q[0] = x;
+        k = 0;
+    } else if (x >= q[4]) {
+        q[4] = x;
+        k = 3;
+    } else {
+        k = 0;
+        while (x >= q[k+1]) k++;
+    }
+
+    for (int i = k + 1; i < 5; i++) n[i]++;
+    for (int i = 0; i < 5; i++) desired[i] += increment[i];
+
+    // adjust the middle markers toward their desired positions
+    for (int i = 1; i < 4; i++) {
+        float d = desired[i] - n[i];
+
+        if ((d >= 1.0f && n[i+1] - n[i] > 1) || (d <= -1.0f && n[i-1] - n[i] < -1)) {
+            int step = (d > 0.0f) ? 1 : -1;
+            float estimate = Parabolic(i, (float) step);
+
+            if (q[i-1] < estimate && estimate < q[i+1]) {
+                q[i] = estimate;
+            } else {
+                q[i] = Linear(i, step);
+            }
+
+            n[i] += step;
+        }
+    }
+
+    if (count < UINT16_MAX) count++;
+}
+
+float P2Quantile::Value()
+{
+    float sorted[5] = {0};
+
+    if (0 == count) return 0.0f;
+    if (count >= 5) return q[2];
+
+    // too few samples for the markers, pick from the sorted samples
+    for (int i = 0; i < count; i++) {
+        float temp = q[i];
+        int j = i - 1;
+        while (j >= 0 && sorted[j] > temp) {
+            sorted[j+1] = sorted[j];
+            j--;
+        }
+        sorted[j+1] = temp;
+    }
+
+    return sorted[(int) (p * (count - 1) + 0.5f)];
+}
+
+float P2Quantile::Parabolic(int i, float d)
+{
+    return q[i] + d / (n[i+1] - n[i-1]) * ((n[i] - n[i-1] + d) * (q[i+1] - q[i]) / (n[i+1] - n[i])
+                                         + (n[i+1] - n[i] - d) * (q[i] - q[i-1]) / (n[i] - n[i-1]));
+}
+
+float P2Quantile::Linear(int i, int d)
+{
+    return q[i] + d * (q[i+d] - q[i]) / (n[i+d] - n[i]);
+}
+
+void MotionStats::Reset()
+{
+    for (int i = 0; i < NUM_MOTION_STATS; i++) {
+        stats[i].Reset();
+        median[i].Reset();
+        high[i].Reset();
+    }
+}
+
+void MotionStats::Add(const float * values)
+{
+    for (int i = 0; i < NUM_MOTION_STATS; i++) {
+        stats[i].Add(values[i]);
+        median[i].Add(values[i]);
+        high[i].Add(values[i]);
+    }
+}
+
+void MotionStats::Summary(MotionChannel_t channel, float * out)
+{
+    if (channel >= NUM_MOTION_STATS) return;
+
+    out[0] = stats[channel].Mean();
+    out[1] = stats[channel].StdDev();
+    out[2] = stats[channel].Min();
+    out[3] = stats[channel].Max();
+    out[4] = median[channel].Value();
+    out[5] = high[channel].Value();
+}
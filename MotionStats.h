@@ -0,0 +1,94 @@
+/*
+ *  MotionStats.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Streaming statistics over the MCB motion TM, kept for the length of one
+ *  motion: Welford mean and variance, min and max, and P-squared estimates of
+ *  the median and 95th percentile (five markers each, so no samples are
+ *  stored). A summary is sent at the end of each motion so that motor
+ *  degradation can be tracked without downloading the full motion TM.
+ *
+ *  No Arduino dependencies.
+ */
+
+#ifndef MOTIONSTATS_H
+#define MOTIONSTATS_H
+
+#include "MotionTM.h"
+#include <stdint.h>
+
+enum MotionChannel_t : uint8_t {
+    MOTION_STAT_CURRENT,
+    MOTION_STAT_TORQUE,
+    MOTION_STAT_TEMP,
+    MOTION_STAT_SPEED,
+    NUM_MOTION_STATS
+};
+
+// floats per channel in the summary: mean, std dev, min, max, median, 95th percentile
+#define MOTION_STAT_FIELDS  6
+
+// Welford running mean and variance, with min and max
+class RunningStats {
+public:
+    void Reset();
+    void Add(float x);
+
+    uint16_t Count() { return count; }
+    float Mean() { return mean; }
+    float StdDev();
+    float Min() { return min; }
+    float Max() { return max; }
+
+private:
+    uint16_t count = 0;
+    float mean = 0.0f;
+    float m2 = 0.0f;
+    float min = 0.0f;
+    float max = 0.0f;
+};
+
+// Jain and Chlamtac P-squared estimate of a single quantile
+class P2Quantile {
+public:
+    P2Quantile(float p) : p(p) { };
+
+    void Reset() { count = 0; }
+    void Add(float x);
+    float Value();
+
+private:
+    float Parabolic(int i, float d);
+    float Linear(int i, int d);
+
+    float p;
+    uint16_t count = 0;
+    float q[5] = {0};       // marker heights
+    int32_t n[5] = {0};     // marker positions
+    float desired[5] = {0}; // desired marker positions
+    float increment[5] = {0};
+};
+
+class MotionStats {
+public:
+    MotionStats() { };
+    ~MotionStats() { };
+
+    void Reset();
+
+    // one decoded motion TM frame, indexed by MotionChannel_t
+    void Add(const float * values);
+
+    uint16_t Samples() { return stats[0].Count(); }
+
+    // MOTION_STAT_FIELDS floats for the channel
+    void Summary(MotionChannel_t channel, float * out);
+
+private:
+    RunningStats stats[NUM_MOTION_STATS];
+    P2Quantile median[NUM_MOTION_STATS] = {0.5f, 0.5f, 0.5f, 0.5f};
+    P2Quantile high[NUM_MOTION_STATS] = {0.95f, 0.95f, 0.95f, 0.95f};
+};
+
+#endif /* MOTIONSTATS_H */
@@ -0,0 +1,42 @@
+/*
+ *  MotionTM.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Layout of the MCB motion TM frame (MCB_MOTION_TM, MOTION_TM_SIZE bytes): a
+ *  status byte, then little-endian floats. Every reader of the frame takes its
+ *  offsets from here: the reel tracker, the motion statistics and anomaly
+ *  checks, the decimated real-time TM, and the TM codec.
+ *
+ *  No Arduino dependencies.
+ */
+
+#ifndef MOTIONTM_H
+#define MOTIONTM_H
+
+#include <stdint.h>
+
+#define MOTION_TM_STATUS_INDEX  0
+#define MOTION_TM_FLOAT_INDEX   1
+
+// floats in frame order
+enum MotionTMFloat_t : uint8_t {
+    MOTION_TM_TORQUE,           // reel motor torque
+    MOTION_TM_CURRENT,          // reel motor current
+    MOTION_TM_TEMP,             // reel motor temperature
+    MOTION_TM_SPEED,            // reel speed
+    MOTION_TM_AUX,              // not read by the PIB
+    MOTION_TM_REEL_POSITION,    // reel position (revolutions)
+    NUM_MOTION_TM_FLOATS
+};
+
+#define MOTION_TM_INDEX(field)      (MOTION_TM_FLOAT_INDEX + 4 * (field))
+#define MOTION_TM_FRAME_SIZE        MOTION_TM_INDEX(NUM_MOTION_TM_FLOATS)
+
+#define MOTION_TM_TORQUE_INDEX      MOTION_TM_INDEX(MOTION_TM_TORQUE)
+#define MOTION_TM_CURRENT_INDEX     MOTION_TM_INDEX(MOTION_TM_CURRENT)
+#define MOTION_TM_TEMP_INDEX        MOTION_TM_INDEX(MOTION_TM_TEMP)
+#define MOTION_TM_SPEED_INDEX       MOTION_TM_INDEX(MOTION_TM_SPEED)
+#define MOTION_TM_POSITION_INDEX    MOTION_TM_INDEX(MOTION_TM_REEL_POSITION)
+
+#endif /* MOTIONTM_H */
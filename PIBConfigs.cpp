@@ -15,6 +15,7 @@ PIBConfigs::PIBConfigs()
     , sza_minimum(105)
     , time_trigger(UINT32_MAX)
     , sza_trigger(false)
+    , sza_predict(false)
     , profile_size(7500.0f)
     , dock_amount(200.0f)
     , dock_overshoot(100.0f)
@@ -23,6 +24,13 @@ PIBConfigs::PIBConfigs()
     , deploy_velocity(250.0f)
     , retract_velocity(250.0f)
     , dock_velocity(80.0f)
+    , deploy_acc(0.0f)
+    , retract_acc(0.0f)
+    , dock_acc(0.0f)
+    , drum_core_diameter(0.0f)
+    , cable_diameter(0.0f)
+    , drum_width(0.0f)
+    , docked_cable_length(0.0f)
     , flash_temp(-20.0f)
     , heater1_temp(0.0f)
     , heater2_temp(-15.0f)
@@ -37,15 +45,51 @@ PIBConfigs::PIBConfigs()
     , docked_TSEN(1)
     , docked_ROPC(1)
     , docked_FLASH(1)
+    , compress_pu(false)
+    , pu_delta_stride(0)
     , dwell_time(900)
     , preprofile_time(180)
     , puwarmup_time(900)
     , motion_timeout(30)
-    , profile_period(7200)
+    , profile_period(0)
     , num_profiles(3)
     , num_redock(3)
+    , parallel_ra(false)
+    , charge_gate(false)
+    , pu_ready_voltage(8.0f)
+    , pu_min_voltage(7.2f)
+    , pu_full_current(0.05f)
+    , charge_max_wait(3600)
+    , plan_mode(false)
+    , plan_index(0)
+    , profile_table(ProfileTable_t{})
     , pu_docked(false)
+    , archive_night(0)
+    , archive_profile(0)
+    , archive_tsen(0)
+    , reel_position(0.0f)
+    , reel_position_valid(false)
+    , dock_imon_threshold(0)
+    , dock_tolerance(3.0f)
+    , torque_slope_limit(0.0f)
+    , current_slope_limit(0.0f)
+    , temp_cusum_slack(10.0f)
+    , temp_cusum_limit(0.0f)
     , real_time_mcb(false)
+    , compress_mcb_tm(false)
+    , rt_frames(10)
+    , rt_period(30)
+    , rt_decimate(false)
+    , rt_budget(0)
+    , mcb_retries(1)
+    , pu_retries(1)
+    , zephyr_retries(1)
+    , mcb_rto_min(2)
+    , mcb_rto_max(30)
+    , pu_rto_min(2)
+    , pu_rto_max(30)
+    , zephyr_rto_min(10)
+    , zephyr_rto_max(180)
     // ----------------------------------------------------
 { }
 
@@ -56,6 +100,7 @@ void PIBConfigs::RegisterAll()
     success &= Register(&sza_minimum);
     success &= Register(&time_trigger);
     success &= Register(&sza_trigger);
+    success &= Register(&sza_predict);
     success &= Register(&profile_size);
     success &= Register(&dock_amount);
     success &= Register(&dock_overshoot);
@@ -64,6 +109,13 @@ void PIBConfigs::RegisterAll()
     success &= Register(&deploy_velocity);
     success &= Register(&retract_velocity);
     success &= Register(&dock_velocity);
+    success &= Register(&deploy_acc);
+    success &= Register(&retract_acc);
+    success &= Register(&dock_acc);
+    success &= Register(&drum_core_diameter);
+    success &= Register(&cable_diameter);
+    success &= Register(&drum_width);
+    success &= Register(&docked_cable_length);
     success &= Register(&flash_temp);
     success &= Register(&heater1_temp);
     success &= Register(&heater2_temp);
@@ -78,6 +130,8 @@ void PIBConfigs::RegisterAll()
     success &= Register(&docked_TSEN);
     success &= Register(&docked_ROPC);
     success &= Register(&docked_FLASH);
+    success &= Register(&compress_pu);
+    success &= Register(&pu_delta_stride);
     success &= Register(&dwell_time);
     success &= Register(&preprofile_time);
     success &= Register(&puwarmup_time);
@@ -85,8 +139,42 @@ void PIBConfigs::RegisterAll()
     success &= Register(&profile_period);
     success &= Register(&num_profiles);
     success &= Register(&num_redock);
+    success &= Register(&parallel_ra);
+    success &= Register(&charge_gate);
+    success &= Register(&pu_ready_voltage);
+    success &= Register(&pu_min_voltage);
+    success &= Register(&pu_full_current);
+    success &= Register(&charge_max_wait);
+    success &= Register(&plan_mode);
+    success &= Register(&plan_index);
+    success &= Register(&profile_table);
     success &= Register(&pu_docked);
+    success &= Register(&archive_night);
+    success &= Register(&archive_profile);
+    success &= Register(&archive_tsen);
+    success &= Register(&reel_position);
+    success &= Register(&reel_position_valid);
+    success &= Register(&dock_imon_threshold);
+    success &= Register(&dock_tolerance);
+    success &= Register(&torque_slope_limit);
+    success &= Register(&current_slope_limit);
+    success &= Register(&temp_cusum_slack);
+    success &= Register(&temp_cusum_limit);
     success &= Register(&real_time_mcb);
+    success &= Register(&compress_mcb_tm);
+    success &= Register(&rt_frames);
+    success &= Register(&rt_period);
+    success &= Register(&rt_decimate);
+    success &= Register(&rt_budget);
+    success &= Register(&mcb_retries);
+    success &= Register(&pu_retries);
+    success &= Register(&zephyr_retries);
+    success &= Register(&mcb_rto_min);
+    success &= Register(&mcb_rto_max);
+    success &= Register(&pu_rto_min);
+    success &= Register(&pu_rto_max);
+    success &= Register(&zephyr_rto_min);
+    success &= Register(&zephyr_rto_max);
 
     if (!success) {
         debug_serial->println("Error registering EEPROM configs");
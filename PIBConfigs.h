@@ -16,6 +16,7 @@
 #define PIBCONFIGS_H
 
 #include "TeensyEEPROM.h"
+#include "ProfileTable.h"
 
 class PIBConfigs : public TeensyEEPROM {
 private:
@@ -25,7 +26,7 @@ public:
     PIBConfigs();
 
     // constants, manually change version number here to force update
-    static const uint16_t CONFIG_VERSION = 0x5C02;
+    static const uint16_t CONFIG_VERSION = 0x5C16;
     static const uint16_t BASE_ADDRESS = 0x0000;
 
     // ------------------ Configurations ------------------
@@ -34,6 +35,7 @@ public:
     EEPROMData<float> sza_minimum;
     EEPROMData<uint32_t> time_trigger;
     EEPROMData<bool> sza_trigger; // true if SZA triggers profile, false if profile_time
+    EEPROMData<bool> sza_predict; // start early enough to reel out at the predicted SZA crossing
 
     // profile sizing (in revolutions)
     EEPROMData<float> profile_size;
@@ -47,6 +49,17 @@ public:
     EEPROMData<float> retract_velocity;
     EEPROMData<float> dock_velocity;
 
+    // accelerations last sent to the MCB (in rpm/s, 0 if not yet sent)
+    EEPROMData<float> deploy_acc;
+    EEPROMData<float> retract_acc;
+    EEPROMData<float> dock_acc;
+
+    // drum and cable geometry (in metres, see DrumModel.h), 0 if not configured
+    EEPROMData<float> drum_core_diameter;
+    EEPROMData<float> cable_diameter;
+    EEPROMData<float> drum_width;
+    EEPROMData<float> docked_cable_length;
+
     // PU configuration
     EEPROMData<float> flash_temp;
     EEPROMData<float> heater1_temp;
@@ -63,22 +76,78 @@ public:
     EEPROMData<uint8_t> docked_ROPC;
     EEPROMData<uint8_t> docked_FLASH;
 
+    // PU profile record compression (see PUCompress.h), off until the ground decodes it
+    EEPROMData<bool> compress_pu;
+    EEPROMData<uint8_t> pu_delta_stride; // bytes per record sample, 0 for no delta
+
     // profile timing (seconds)
     EEPROMData<uint16_t> dwell_time;
     EEPROMData<uint16_t> preprofile_time;
     EEPROMData<uint16_t> puwarmup_time;
     EEPROMData<uint16_t> motion_timeout;
-    EEPROMData<uint16_t> profile_period;
+    EEPROMData<uint16_t> profile_period; // minimum spacing of planned profiles, 0 to pack them back to back
 
     // autonomous configurations
-    EEPROMData<uint8_t> num_profiles; // per night
+    EEPROMData<uint8_t> num_profiles; // per night without an SZA window (0 for none), the window decides otherwise
     EEPROMData<uint8_t> num_redock;   // before erroring out
+    EEPROMData<bool> parallel_ra;     // start the PU warmup while waiting for the RA
+
+    // PU charge gate (see PUCharge.h), off until the thresholds are set for the flight PU battery
+    EEPROMData<bool> charge_gate;        // hold or advance profiles on the predicted PU charge
+    EEPROMData<float> pu_ready_voltage;  // V
+    EEPROMData<float> pu_min_voltage;    // V
+    EEPROMData<float> pu_full_current;   // A
+    EEPROMData<uint16_t> charge_max_wait; // seconds to hold a profile before starting anyway
+
+    // profile plan table (see ProfileTable.h)
+    EEPROMData<bool> plan_mode;     // run the table instead of num_profiles
+    EEPROMData<uint8_t> plan_index; // next entry to run
+    EEPROMData<ProfileTable_t> profile_table;
 
     // PU tracking
     EEPROMData<bool> pu_docked;
 
+    // PU record archive keys (see PUArchive.h): local night, profiles and TSEN records so far that night
+    EEPROMData<uint16_t> archive_night;
+    EEPROMData<uint8_t> archive_profile;
+    EEPROMData<uint16_t> archive_tsen;
+
+    // reel position (revs from the dock) saved at the end of each motion, invalid during motion
+    EEPROMData<float> reel_position;
+    EEPROMData<bool> reel_position_valid;
+
+    // dock detection (see DockDetector.h), the IMON_PU threshold is off until calibrated
+    EEPROMData<uint16_t> dock_imon_threshold; // ADC counts, 0 to use only PU UART traffic
+    EEPROMData<float> dock_tolerance;         // revs
+
+    // motion anomaly limits (see MotionAnomaly.h), 0 disables, all off until set from flight data
+    EEPROMData<float> torque_slope_limit;  // per second
+    EEPROMData<float> current_slope_limit; // A per second
+    EEPROMData<float> temp_cusum_slack;    // deg C
+    EEPROMData<float> temp_cusum_limit;    // deg C * s
+
     // MCB TM mode
     EEPROMData<bool> real_time_mcb;
+    EEPROMData<bool> compress_mcb_tm; // buffered frames as keyframe + deltas (see MotionCodec.h), off until the ground decodes it
+
+    // real-time MCB TM packets
+    EEPROMData<uint8_t> rt_frames;   // frames per packet
+    EEPROMData<uint16_t> rt_period;  // seconds per packet, 0 for frames only
+    EEPROMData<bool> rt_decimate;    // min/max/mean per field instead of raw frames
+    EEPROMData<uint16_t> rt_budget;  // bytes per minute, 0 for unlimited
+
+    // request retries per target (see ReliableRequest.h)
+    EEPROMData<uint8_t> mcb_retries;
+    EEPROMData<uint8_t> pu_retries;
+    EEPROMData<uint8_t> zephyr_retries;
+
+    // adaptive request timeout bounds per target (seconds)
+    EEPROMData<uint16_t> mcb_rto_min;
+    EEPROMData<uint16_t> mcb_rto_max;
+    EEPROMData<uint16_t> pu_rto_min;
+    EEPROMData<uint16_t> pu_rto_max;
+    EEPROMData<uint16_t> zephyr_rto_min;
+    EEPROMData<uint16_t> zephyr_rto_max;
 
     // ----------------------------------------------------
 
@@ -0,0 +1,56 @@
+/*
+ *  PIBLogMessages.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  String table for the PIB binary log. Each entry defines a static message
+ *  id, the packed argument types, and the format string used by the ground
+ *  decoder to rebuild the text. The PIB never formats these strings.
+ *
+ *  Argument type characters:
+ *    'b' = uint8_t, 'h' = uint16_t, 'u' = uint32_t, 'i' = int32_t, 'f' = float
+ *
+ *  To add a message, append a PIB_LOG_MESSAGE line at the end of the table.
+ *  *note* never reorder or remove entries: the ids are implicit in the order
+ *  and old logs on the ground are decoded with the same table.
+ */
+
+#ifndef PIBLOGMESSAGES_H
+#define PIBLOGMESSAGES_H
+
+#include <stdint.h>
+
+#define PIB_LOG_MESSAGE_TABLE \
+    PIB_LOG_MESSAGE(BL_REEL_POSITION,      "i",      "Reel position: %ld") \
+    PIB_LOG_MESSAGE(BL_REEL_POSITION_ERR,  "",       "Recieved MCB bin: unable to read position") \
+    PIB_LOG_MESSAGE(BL_START_RETRACT,      "f",      "Retracting %0.1f revs") \
+    PIB_LOG_MESSAGE(BL_START_DEPLOY,       "f",      "Deploying %0.1f revs") \
+    PIB_LOG_MESSAGE(BL_START_DOCK,         "f",      "Docking %0.1f revs") \
+    PIB_LOG_MESSAGE(BL_START_IN_NO_LW,     "f",      "Reel in (no LW) %0.1f revs") \
+    PIB_LOG_MESSAGE(BL_SCHEDULED_DWELL,    "h",      "Scheduled dwell: %u s") \
+    PIB_LOG_MESSAGE(BL_TSEN_RECEIVED,      "h",      "Received TSEN: %u") \
+    PIB_LOG_MESSAGE(BL_RECORD_RECEIVED,    "h",      "Received profile record: %u") \
+    PIB_LOG_MESSAGE(BL_PU_STATUS,          "uffffb", "PU status: %lu, %0.2f, %0.2f, %0.2f, %0.2f, %u") \
+    PIB_LOG_MESSAGE(BL_PU_STATUS_INVALID,  "",       "PU status invalid") \
+    PIB_LOG_MESSAGE(BL_MCB_TM_PACKET,      "h",      "MCB TM Packet %u") \
+    PIB_LOG_MESSAGE(BL_SZA_PREDICTION,     "uf",     "SZA crossing predicted at %lu (SZA now %0.2f)") \
+    PIB_LOG_MESSAGE(BL_CHARGE_HOLD,        "uff",    "Holding profile %lu s for PU charge: %0.2f V, %0.2f A") \
+    PIB_LOG_MESSAGE(BL_CHARGE_ADVANCE,     "uff",    "PU charged, profile advanced %lu s: %0.2f V, %0.2f A") \
+    PIB_LOG_MESSAGE(BL_REEL_SAVED,         "f",      "Reel position saved: %0.2f revs") \
+    PIB_LOG_MESSAGE(BL_DOCK_FROM_POSITION, "ff",     "Dock sized from reel position %0.2f: %0.2f revs") \
+    PIB_LOG_MESSAGE(BL_DOCK_DETECTED,      "bhh",    "Dock detection: %u (1 docked, 2 not) after %u ms, IMON %u") \
+    PIB_LOG_MESSAGE(BL_MOTION_STATS,       "hff",    "Motion stats: %u frames, current mean %0.2f, max %0.2f") \
+    PIB_LOG_MESSAGE(BL_MOTION_ANOMALY,     "bff",    "Motion anomaly %u: %0.2f > %0.2f") \
+    PIB_LOG_MESSAGE(BL_MCB_TM_SEGMENT,     "hb",     "MCB TM motion %u segment %u sent") \
+    PIB_LOG_MESSAGE(BL_PU_COMPRESSED,      "hhu",    "PU record compressed: %u to %u bytes in %lu us") \
+    PIB_LOG_MESSAGE(BL_PU_ARCHIVED,        "hbhh",   "PU record archived: night %u, profile %u, packet %u, %u bytes") \
+    PIB_LOG_MESSAGE(BL_SD_OVERFLOW,        "uuh",    "SD queue full: %lu records, %lu bytes dropped, %u errors") \
+
+#define PIB_LOG_MESSAGE(id, types, format) id,
+enum PIBLogMessage_t : uint8_t {
+    PIB_LOG_MESSAGE_TABLE
+    NUM_PIB_LOG_MESSAGES
+};
+#undef PIB_LOG_MESSAGE
+
+#endif /* PIBLOGMESSAGES_H */
@@ -0,0 +1,42 @@
+/*
+ *  PIBLogging.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Per-call-site rate limiting for the debug serial log
+ */
+
+#include "PIBLogging.h"
+#include "Arduino.h"
+
+// the rate-limited call site that logged most recently
+static LogCallSite_t * active_site = NULL;
+
+static void FlushRepeats(LogCallSite_t * site)
+{
+    char repeat_array[101] = {0};
+
+    if (NULL == site || 0 == site->repeats) return;
+
+    snprintf(repeat_array, sizeof(repeat_array), "%s (repeated %u times)", site->message, site->repeats);
+    log_debug(repeat_array);
+
+    site->repeats = 0;
+}
+
+void LogDebugLimited(LogCallSite_t * site)
+{
+    uint32_t now_ms = millis();
+
+    // collapse consecutive repeats from the same site within the window
+    if (site == active_site && now_ms - site->last_logged < LOG_REPEAT_WINDOW_MS) {
+        if (site->repeats < UINT16_MAX) site->repeats++;
+        return;
+    }
+
+    FlushRepeats(active_site);
+
+    log_debug(site->message);
+    site->last_logged = now_ms;
+    active_site = site;
+}
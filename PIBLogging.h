@@ -0,0 +1,60 @@
+/*
+ *  PIBLogging.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Compile-time log levels and per-call-site rate limiting for the debug
+ *  serial log. In a flight build (PIB_FLIGHT_BUILD defined below) the debug
+ *  macros compile to nothing.
+ *
+ *  PIB_LOG_DEBUG_LIMITED is for messages logged once per loop in a waiting
+ *  state: the first call is logged, then repeats from the same call site are
+ *  counted and collapsed into a single "repeated N times" line, which is
+ *  printed when a different rate-limited site logs or the window expires.
+ */
+
+#ifndef PIBLOGGING_H
+#define PIBLOGGING_H
+
+#include "StratoGroundPort.h"
+#include <stdint.h>
+
+// uncomment for flight builds to remove debug logging at compile time
+// #define PIB_FLIGHT_BUILD
+
+#define PIB_LOG_LEVEL_DEBUG     0
+#define PIB_LOG_LEVEL_NOMINAL   1
+#define PIB_LOG_LEVEL_ERROR     2
+
+#ifndef PIB_LOG_LEVEL
+#ifdef PIB_FLIGHT_BUILD
+#define PIB_LOG_LEVEL   PIB_LOG_LEVEL_NOMINAL
+#else
+#define PIB_LOG_LEVEL   PIB_LOG_LEVEL_DEBUG
+#endif
+#endif
+
+// a repeated message is logged again after this long, with its repeat count
+#define LOG_REPEAT_WINDOW_MS    60000
+
+struct LogCallSite_t {
+    const char * message;
+    uint32_t last_logged;
+    uint16_t repeats;
+};
+
+// log through the call site's rate limiter (in PIBLogging.cpp)
+void LogDebugLimited(LogCallSite_t * site);
+
+#if PIB_LOG_LEVEL <= PIB_LOG_LEVEL_DEBUG
+#define PIB_LOG_DEBUG(msg)          log_debug(msg)
+#define PIB_LOG_DEBUG_LIMITED(msg)  do { \
+                                        static LogCallSite_t log_site = {msg, 0, 0}; \
+                                        LogDebugLimited(&log_site); \
+                                    } while (0)
+#else
+#define PIB_LOG_DEBUG(msg)          do { } while (0)
+#define PIB_LOG_DEBUG_LIMITED(msg)  do { } while (0)
+#endif
+
+#endif /* PIBLOGGING_H */
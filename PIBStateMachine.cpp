@@ -0,0 +1,125 @@
+/*
+ *  PIBStateMachine.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  A small table-driven state machine engine for the Flight_* event sequences
+ */
+
+#include "PIBStateMachine.h"
+#include "StratoGroundPort.h"
+#include "Arduino.h"
+
+SMTraceHook_t StateMachine::trace_hook = NULL;
+uint8_t StateMachine::num_instances[SM_MAX_IDS] = {0};
+
+StateMachine::StateMachine(uint8_t machine_id, const SMStateDef_t * state_table, uint8_t num_state_defs,
+                           const SMTransition_t * transition_table, uint8_t num_transition_defs)
+    : id(machine_id)
+    , instance((machine_id < SM_MAX_IDS) ? num_instances[machine_id]++ : 0)
+    , states(state_table)
+    , transitions(transition_table)
+    , num_states(num_state_defs)
+    , num_transitions(num_transition_defs)
+{
+}
+
+void StateMachine::Restart()
+{
+    Enter(0, SM_EV_RESTART);
+}
+
+uint8_t StateMachine::Run()
+{
+    // a state isn't timed out in the loop it is entered
+    if (!entry_pending && 0 != timeout_ms && millis() - state_start >= timeout_ms) {
+        Retry();
+    }
+
+    // time the state (and any request attempt) from the loop its entry actions run
+    if (entry_pending) {
+        state_start = millis();
+        if (request.Active()) request.Sent();
+    }
+
+    entered = entry_pending;
+    entry_pending = false;
+
+    return state;
+}
+
+bool StateMachine::Dispatch(uint8_t event)
+{
+    for (int i = 0; i < num_transitions; i++) {
+        if (transitions[i].state == state && transitions[i].event == event) {
+            Enter(transitions[i].next, event);
+            return true;
+        }
+    }
+
+    log_error("State machine event with no transition");
+    return false;
+}
+
+void StateMachine::SetTimeout(uint16_t seconds)
+{
+    timeout_ms = 1000 * (uint32_t) seconds;
+    state_start = millis();
+}
+
+void StateMachine::Retry()
+{
+    if (RetryAllowed()) {
+        retry_count++;
+        Enter(state, SM_EV_RETRY);
+    } else if (!Dispatch(SM_EV_TIMEOUT)) {
+        timeout_ms = 0; // no timeout transition, stay put and don't report again
+    }
+}
+
+bool StateMachine::RetryAllowed()
+{
+    if (REQ_NONE != states[state].request) {
+        return request.Retry(); // records the failure if not
+    }
+
+    return retry_count < states[state].retries;
+}
+
+void StateMachine::Enter(uint8_t next_state, uint8_t event)
+{
+    if (next_state >= num_states) {
+        log_error("State machine transition out of bounds");
+        return;
+    }
+
+    if (NULL != trace_hook) {
+        trace_hook(id, instance, state, event, next_state);
+    }
+
+    if (SM_EV_RETRY != event) {
+        // leaving a request state for any other reason than a timeout, cancel, or restart means it was acked
+        if (request.Active()) {
+            if (SM_EV_RESTART == event || SM_EV_CANCEL == event) {
+                request.Cancel();
+            } else {
+                request.Complete();
+            }
+        }
+
+        retry_count = 0;
+        request.Start((RequestID_t) states[next_state].request);
+    }
+
+    state = next_state;
+    state_start = millis();
+
+    if (request.Active()) {
+        timeout_ms = request.AttemptTimeout();
+    } else {
+        timeout_ms = 1000 * (uint32_t) states[state].timeout;
+    }
+
+    entry_pending = true;
+    transition_count++;
+}
@@ -0,0 +1,117 @@
+/*
+ *  PIBStateMachine.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  A small table-driven state machine engine for the Flight_* event sequences.
+ *
+ *  Each machine is described by two constant tables in its source file:
+ *    1) a state table, indexed by state, giving each state's timeout and the
+ *       number of times it is re-entered on timeout before SM_EV_TIMEOUT, or
+ *       a request id for states that wait on an ack (see ReliableRequest.h),
+ *       which then supplies the per-target retries and backed-off timeouts
+ *    2) a transition table of (state, event) -> next state
+ *
+ *  The Flight_* function calls Run() once per loop and switches on the
+ *  returned state. Entry actions (ie. sending a command) are performed when
+ *  Entered() is true, which is the case for exactly one loop after the state
+ *  is entered or re-entered for a retry. Transitions only happen through
+ *  Dispatch(), and every transition is reported to the trace hook. Leaving a
+ *  request state on any event but SM_EV_TIMEOUT or SM_EV_CANCEL completes the
+ *  request.
+ */
+
+#ifndef PIBSTATEMACHINE_H
+#define PIBSTATEMACHINE_H
+
+#include "ReliableRequest.h"
+#include <stdint.h>
+
+// common events, machine-specific events start at SM_EV_USER
+enum SMEvent_t : uint8_t {
+    SM_EV_NONE = 0,
+    SM_EV_RESTART,  // reported to the trace hook only
+    SM_EV_RETRY,    // reported to the trace hook only
+    SM_EV_NEXT,     // the state's work is done
+    SM_EV_TIMEOUT,  // timed out with no retries left
+    SM_EV_CANCEL,   // abandon the state (a pending request isn't counted as acked)
+    SM_EV_USER
+};
+
+struct SMStateDef_t {
+    uint16_t timeout; // seconds, 0 for no timeout
+    uint8_t retries;  // re-entries on timeout before SM_EV_TIMEOUT
+    uint8_t request;  // RequestID_t, overrides timeout and retries unless REQ_NONE
+};
+
+struct SMTransition_t {
+    uint8_t state;
+    uint8_t event;
+    uint8_t next;
+};
+
+#define SM_TABLE_SIZE(table) (sizeof(table) / sizeof(table[0]))
+
+// machine ids are below SM_MAX_IDS, and instances are numbered per id
+#define SM_MAX_IDS  15
+
+typedef void (*SMTraceHook_t)(uint8_t machine_id, uint8_t instance, uint8_t state, uint8_t event, uint8_t next);
+
+class StateMachine {
+public:
+    StateMachine(uint8_t machine_id, const SMStateDef_t * state_table, uint8_t num_state_defs,
+                 const SMTransition_t * transition_table, uint8_t num_transition_defs);
+    ~StateMachine() { };
+
+    // enter state 0
+    void Restart();
+
+    // handle timeouts and retries, returns the current state (call once per loop)
+    uint8_t Run();
+
+    // perform the transition for the event in the current state, false if none exists
+    bool Dispatch(uint8_t event);
+
+    // override the current state's timeout (for configurable waits)
+    void SetTimeout(uint16_t seconds);
+
+    // the current attempt failed (ie. NAK), re-enter if retries remain, otherwise SM_EV_TIMEOUT
+    void Retry();
+
+    // true for the first loop in a state, including re-entries for retries
+    bool Entered() { return entered; }
+
+    uint8_t State() { return state; }
+    uint8_t RetryCount() { return retry_count; }
+    uint16_t TransitionCount() { return transition_count; }
+
+    const uint8_t id;
+    const uint8_t instance; // numbered per id in construction order to tell apart machines with the same id
+
+    // a single hook that observes every transition of every machine
+    static void SetTraceHook(SMTraceHook_t hook) { trace_hook = hook; }
+
+private:
+    void Enter(uint8_t next_state, uint8_t event);
+    bool RetryAllowed();
+
+    const SMStateDef_t * states;
+    const SMTransition_t * transitions;
+    const uint8_t num_states;
+    const uint8_t num_transitions;
+
+    uint8_t state = 0;
+    uint8_t retry_count = 0;
+    uint16_t transition_count = 0;
+    uint32_t timeout_ms = 0;
+    uint32_t state_start = 0;
+    bool entry_pending = true;
+    bool entered = false;
+
+    ReliableRequest request;
+
+    static SMTraceHook_t trace_hook;
+    static uint8_t num_instances[SM_MAX_IDS];
+};
+
+#endif /* PIBSTATEMACHINE_H */
@@ -0,0 +1,276 @@
+/*
+ *  PUArchive.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  SD card archive of PU records with an index for retransmits
+ */
+
+#include "PUArchive.h"
+#include <SD.h>
+#include <string.h>
+
+void PUArchive::PutKey(uint8_t * buffer, uint16_t night, uint8_t profile, uint16_t packet)
+{
+    buffer[0] = (uint8_t) night;
+    buffer[1] = (uint8_t) (night >> 8);
+    buffer[2] = profile;
+    buffer[3] = (uint8_t) packet;
+    buffer[4] = (uint8_t) (packet >> 8);
+}
+
+bool PUArchive::Append(uint16_t night, uint8_t profile, uint16_t packet, const uint8_t * record, uint16_t length)
+{
+    uint8_t header[PU_ARCHIVE_QUEUED] = {0};
+
+    if (PU_ARCHIVE_QUEUED + (uint32_t) length > (uint32_t) (PU_ARCHIVE_QUEUE - used)) {
+        dropped++;
+        return false;
+    }
+
+    PutKey(header, night, profile, packet);
+    header[5] = (uint8_t) length;
+    header[6] = (uint8_t) (length >> 8);
+
+    Put(header, PU_ARCHIVE_QUEUED);
+    Put(record, length);
+
+    return true;
+}
+
+uint16_t PUArchive::Service(uint32_t time_ms)
+{
+    uint16_t chunk = PU_ARCHIVE_CHUNK;
+    uint16_t written = 0;
+
+    if (!writing && 0 == used) return 0;
+
+    if (retrying && time_ms - retry_start < PU_ARCHIVE_RETRY_MS) return 0;
+    retrying = false;
+
+    if (!writing) {
+        data_file = SD.open(PU_ARCHIVE_DATA, FILE_WRITE);
+        if (!data_file) {
+            errors++;
+            retrying = true;
+            retry_start = time_ms;
+            return 0; // the record stays queued
+        }
+
+        if (!StartRecord()) {
+            Abandon(time_ms);
+            return 0;
+        }
+    }
+
+    // one contiguous piece of the ring per call
+    if (chunk > write_remaining) chunk = write_remaining;
+    if (chunk > PU_ARCHIVE_QUEUE - tail) chunk = PU_ARCHIVE_QUEUE - tail;
+
+    if (0 != chunk) {
+        written = data_file.write(ring + tail, chunk);
+        Skip(written);
+        write_remaining -= written;
+
+        if (written != chunk) {
+            Abandon(time_ms);
+            return written;
+        }
+    }
+
+    if (0 == write_remaining) {
+        data_file.close();
+        writing = false;
+
+        // index the record only once its data is written
+        if (!WriteIndex()) errors++;
+    }
+
+    return written;
+}
+
+bool PUArchive::StartRecord()
+{
+    uint8_t header[PU_ARCHIVE_HEADER] = {0};
+    uint8_t queued[PU_ARCHIVE_QUEUED] = {0};
+
+    Get(queued, PU_ARCHIVE_QUEUED);
+    memcpy(write_key, queued, 5);
+    write_length = queued[5] | (queued[6] << 8);
+    write_remaining = write_length;
+    writing = true;
+
+    header[0] = PU_ARCHIVE_SYNC;
+    memcpy(header + 1, write_key, 5);
+    header[6] = queued[5];
+    header[7] = queued[6];
+
+    write_offset = data_file.size() + PU_ARCHIVE_HEADER;
+
+    return PU_ARCHIVE_HEADER == data_file.write(header, PU_ARCHIVE_HEADER);
+}
+
+bool PUArchive::WriteIndex()
+{
+    uint8_t entry[PU_ARCHIVE_ENTRY] = {0};
+    File file = SD.open(PU_ARCHIVE_INDEX, FILE_WRITE);
+
+    if (!file) return false;
+
+    memcpy(entry, write_key, 5);
+    for (int i = 0; i < 4; i++) {
+        entry[5 + i] = (uint8_t) (write_offset >> (8 * i));
+    }
+    entry[9] = (uint8_t) write_length;
+    entry[10] = (uint8_t) (write_length >> 8);
+
+    if (PU_ARCHIVE_ENTRY != file.write(entry, PU_ARCHIVE_ENTRY)) {
+        file.close();
+        return false;
+    }
+    file.close();
+
+    return true;
+}
+
+// a failed write drops the rest of the record, which is never indexed
+void PUArchive::Abandon(uint32_t time_ms)
+{
+    data_file.close();
+    Skip(write_remaining);
+    write_remaining = 0;
+    writing = false;
+
+    errors++;
+    retrying = true;
+    retry_start = time_ms;
+}
+
+void PUArchive::Put(const uint8_t * data, uint16_t length)
+{
+    uint16_t first = 0;
+
+    if (0 == length) return;
+
+    // copy up to the end of the ring, then wrap
+    first = PU_ARCHIVE_QUEUE - head;
+    if (first > length) first = length;
+
+    memcpy(ring + head, data, first);
+    memcpy(ring, data + first, length - first);
+
+    head = (head + length) % PU_ARCHIVE_QUEUE;
+    used += length;
+}
+
+void PUArchive::Get(uint8_t * data, uint16_t length)
+{
+    uint16_t first = PU_ARCHIVE_QUEUE - tail;
+
+    if (first > length) first = length;
+
+    memcpy(data, ring + tail, first);
+    memcpy(data + first, ring, length - first);
+
+    Skip(length);
+}
+
+void PUArchive::Skip(uint16_t length)
+{
+    tail = (tail + length) % PU_ARCHIVE_QUEUE;
+    used -= length;
+}
+
+uint16_t PUArchive::Read(uint16_t night, uint8_t profile, uint16_t packet, uint8_t * buffer, uint16_t size)
+{
+    PUArchiveLocation_t location = {};
+
+    if (0 == Locate(night, profile, packet, 1, &location)) return 0;
+
+    return ReadAt(night, profile, packet, location, buffer, size);
+}
+
+uint16_t PUArchive::ReadAt(uint16_t night, uint8_t profile, uint16_t packet, const PUArchiveLocation_t & location, uint8_t * buffer, uint16_t size)
+{
+    uint8_t header[PU_ARCHIVE_HEADER] = {0};
+    uint8_t expected[5] = {0};
+    uint32_t offset = location.offset;
+    uint16_t length = location.length;
+    File file;
+
+    if (0 == length || length > size || offset < PU_ARCHIVE_HEADER) return 0;
+
+    file = SD.open(PU_ARCHIVE_DATA, FILE_READ);
+    if (!file) return 0;
+
+    // check the record header against the index before trusting the offset
+    PutKey(expected, night, profile, packet);
+    if (!file.seek(offset - PU_ARCHIVE_HEADER) || PU_ARCHIVE_HEADER != file.read(header, PU_ARCHIVE_HEADER) ||
+        PU_ARCHIVE_SYNC != header[0] || 0 != memcmp(header + 1, expected, 5) || length != file.read(buffer, length)) {
+        file.close();
+        return 0;
+    }
+
+    file.close();
+    return length;
+}
+
+uint32_t PUArchive::Entries()
+{
+    uint32_t entries = 0;
+    File file = SD.open(PU_ARCHIVE_INDEX, FILE_READ);
+
+    if (!file) return 0;
+
+    entries = file.size() / PU_ARCHIVE_ENTRY;
+    file.close();
+
+    return entries;
+}
+
+uint16_t PUArchive::Locate(uint16_t night, uint8_t profile, uint16_t first_packet, uint16_t count, PUArchiveLocation_t * locations)
+{
+    uint8_t block[PU_ARCHIVE_BLOCK * PU_ARCHIVE_ENTRY] = {0};
+    uint8_t * entry = NULL;
+    uint32_t entries = 0;
+    uint16_t block_entries = 0;
+    uint16_t index = 0;
+    uint16_t length = 0;
+    uint16_t found = 0;
+    File file;
+
+    memset(locations, 0, count * sizeof(PUArchiveLocation_t));
+
+    if (0 == count) return 0;
+
+    file = SD.open(PU_ARCHIVE_INDEX, FILE_READ);
+    if (!file) return 0;
+
+    entries = file.size() / PU_ARCHIVE_ENTRY;
+
+    // newest first, so a record archived again (ie. after a resend) wins
+    while (entries > 0 && found < count) {
+        block_entries = (entries > PU_ARCHIVE_BLOCK) ? PU_ARCHIVE_BLOCK : (uint16_t) entries;
+        entries -= block_entries;
+
+        if (!file.seek(entries * PU_ARCHIVE_ENTRY) ||
+            block_entries * PU_ARCHIVE_ENTRY != file.read(block, block_entries * PU_ARCHIVE_ENTRY)) break;
+
+        while (block_entries-- > 0 && found < count) {
+            entry = block + block_entries * PU_ARCHIVE_ENTRY;
+            if (night != (entry[0] | (entry[1] << 8)) || profile != entry[2]) continue;
+
+            // packets before first_packet wrap past count
+            index = (uint16_t) ((entry[3] | (entry[4] << 8)) - first_packet);
+            length = entry[9] | (entry[10] << 8);
+            if (index >= count || 0 != locations[index].length || 0 == length) continue;
+
+            locations[index].offset = entry[5] | (entry[6] << 8) | ((uint32_t) entry[7] << 16) | ((uint32_t) entry[8] << 24);
+            locations[index].length = length;
+            found++;
+        }
+    }
+
+    file.close();
+    return found;
+}
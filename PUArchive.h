@@ -0,0 +1,111 @@
+/*
+ *  PUArchive.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Append-only SD card archive of every PU record received, so that records
+ *  can be retransmitted on request without the PU. Records are keyed by
+ *  night, profile, and packet number; profile 0 holds the night's TSEN
+ *  records, numbered in the order they were received.
+ *
+ *    data file:  per record, 0x5A, night (u16), profile (u8), packet (u16),
+ *                length (u16), then the raw record
+ *    index file: per record, night (u16), profile (u8), packet (u16),
+ *                offset of the raw record in the data file (u32), length (u16)
+ *
+ *  Appended records are copied into a RAM queue, and the loop writes them out
+ *  PU_ARCHIVE_CHUNK bytes per call (as SDWriter.h does for the MCB data), so
+ *  the offload and TSEN states never wait on the SD card. A record that doesn't
+ *  fit in the queue is refused whole and counted. A queued record can't be
+ *  retransmitted until it has been written and indexed.
+ *
+ *  The data is written before its index entry, so the index never points past
+ *  the data, and the data file alone is enough to rebuild the index.
+ *
+ *  The index is searched newest first, PU_ARCHIVE_BLOCK entries per read. A
+ *  retransmit locates its whole range in one pass rather than a pass per packet.
+ */
+
+#ifndef PUARCHIVE_H
+#define PUARCHIVE_H
+
+#include <SD.h>
+#include <stdint.h>
+
+#define PU_ARCHIVE_DATA     "PUARCH.DAT"
+#define PU_ARCHIVE_INDEX    "PUARCH.IDX"
+#define PU_ARCHIVE_SYNC     0x5A
+#define PU_ARCHIVE_HEADER   8
+#define PU_ARCHIVE_ENTRY    11
+#define PU_ARCHIVE_TSEN     0 // profile number for TSEN records
+#define PU_ARCHIVE_BLOCK    46 // index entries per read (506 bytes, within one SD block)
+#define PU_ARCHIVE_RANGE    128 // most packets per retransmit request
+#define PU_ARCHIVE_QUEUE    16384 // bytes of RAM for records waiting to be written
+#define PU_ARCHIVE_QUEUED   7 // queue header per record: night, profile, packet, length
+#define PU_ARCHIVE_CHUNK    512 // record bytes written per call (one SD block)
+#define PU_ARCHIVE_RETRY_MS 5000
+
+// where a record's data is in the data file, length 0 if it isn't archived
+struct PUArchiveLocation_t {
+    uint32_t offset;
+    uint16_t length;
+};
+
+class PUArchive {
+public:
+    PUArchive() { };
+    ~PUArchive() { };
+
+    // copy a record into the queue to be archived, false (and counted) if it doesn't fit
+    bool Append(uint16_t night, uint8_t profile, uint16_t packet, const uint8_t * record, uint16_t length);
+
+    // write at most one chunk of queued records, returns the record bytes written
+    uint16_t Service(uint32_t time_ms);
+
+    uint16_t Queued() { return used; }
+    uint32_t Dropped() { return dropped; }
+    uint16_t Errors() { return errors; }
+
+    // Read the latest copy of the record into buffer. Returns the record length, or 0 if
+    // it isn't in the archive, doesn't fit in size, or can't be read.
+    uint16_t Read(uint16_t night, uint8_t profile, uint16_t packet, uint8_t * buffer, uint16_t size);
+
+    // Locate the latest copy of each of count packets from first_packet, stopping once all
+    // are found. Returns the number found.
+    uint16_t Locate(uint16_t night, uint8_t profile, uint16_t first_packet, uint16_t count, PUArchiveLocation_t * locations);
+
+    // Read a located record into buffer, with the same returns as Read
+    uint16_t ReadAt(uint16_t night, uint8_t profile, uint16_t packet, const PUArchiveLocation_t & location, uint8_t * buffer, uint16_t size);
+
+    // records in the index
+    uint32_t Entries();
+
+private:
+    void Put(const uint8_t * data, uint16_t length);
+    void Get(uint8_t * data, uint16_t length);
+    void Skip(uint16_t length);
+    bool StartRecord();
+    bool WriteIndex();
+    void Abandon(uint32_t time_ms);
+    static void PutKey(uint8_t * buffer, uint16_t night, uint8_t profile, uint16_t packet);
+
+    uint8_t ring[PU_ARCHIVE_QUEUE] = {0};
+    uint16_t head = 0; // next byte to queue
+    uint16_t tail = 0; // next byte to write
+    uint16_t used = 0;
+
+    // the record being written, the data file stays open until it's done
+    File data_file;
+    bool writing = false;
+    uint8_t write_key[5] = {0};
+    uint16_t write_length = 0;
+    uint16_t write_remaining = 0;
+    uint32_t write_offset = 0;
+
+    bool retrying = false;
+    uint32_t retry_start = 0; // ms
+    uint32_t dropped = 0;
+    uint16_t errors = 0;
+};
+
+#endif /* PUARCHIVE_H */
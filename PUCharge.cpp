@@ -0,0 +1,94 @@
+/*
+ *  PUCharge.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Estimates the PU battery charge state
+ */
+
+#include "PUCharge.h"
+
+void PUChargeModel::AddStatus(uint32_t time, float v_battery, float i_charge)
+{
+    if (v_battery <= 0.0f) return;
+
+    // a status from the past means the time was reset, start over
+    if (0 != count && time < Latest().time) Reset();
+
+    samples[head].time = time;
+    samples[head].v_battery = v_battery;
+    samples[head].i_charge = i_charge;
+
+    head = (head + 1) % PU_CHARGE_HISTORY;
+    if (count < PU_CHARGE_HISTORY) count++;
+}
+
+bool PUChargeModel::ChargeRate(float * rate)
+{
+    float mean_t = 0.0f;
+    float mean_v = 0.0f;
+    float num = 0.0f;
+    float den = 0.0f;
+    uint32_t t0 = 0;
+
+    if (count < 2 || Latest().time - Oldest().time < PU_CHARGE_MIN_SPAN) return false;
+
+    // fit relative to the oldest sample to keep the float math precise
+    t0 = Oldest().time;
+
+    for (uint8_t i = 0; i < count; i++) {
+        ChargeSample_t & sample = samples[(head + PU_CHARGE_HISTORY - count + i) % PU_CHARGE_HISTORY];
+        mean_t += (float) (sample.time - t0);
+        mean_v += sample.v_battery;
+    }
+
+    mean_t /= count;
+    mean_v /= count;
+
+    for (uint8_t i = 0; i < count; i++) {
+        ChargeSample_t & sample = samples[(head + PU_CHARGE_HISTORY - count + i) % PU_CHARGE_HISTORY];
+        float dt = (float) (sample.time - t0) - mean_t;
+        num += dt * (sample.v_battery - mean_v);
+        den += dt * dt;
+    }
+
+    if (den <= 0.0f) return false;
+
+    *rate = num / den;
+    return true;
+}
+
+bool PUChargeModel::Fresh(uint32_t time)
+{
+    return 0 != count && time >= Latest().time && time - Latest().time <= PU_CHARGE_STALE;
+}
+
+bool PUChargeModel::Ready(uint32_t time, const ChargeThresholds_t & thresholds)
+{
+    if (!Fresh(time) || Latest().v_battery < thresholds.min_voltage) return false;
+
+    return Latest().v_battery >= thresholds.ready_voltage || Latest().i_charge <= thresholds.full_current;
+}
+
+bool PUChargeModel::SecondsToReady(uint32_t time, const ChargeThresholds_t & thresholds, uint32_t * seconds)
+{
+    float rate = 0.0f;
+    float remaining = 0.0f;
+    uint32_t elapsed = 0;
+
+    if (!Fresh(time)) return false;
+
+    if (Ready(time, thresholds)) {
+        *seconds = 0;
+        return true;
+    }
+
+    // only predictable if the battery is charging
+    if (!ChargeRate(&rate) || rate <= 0.0f) return false;
+
+    remaining = (thresholds.ready_voltage - Latest().v_battery) / rate;
+    elapsed = time - Latest().time;
+
+    *seconds = (remaining > elapsed) ? (uint32_t) remaining - elapsed : 0;
+    return true;
+}
@@ -0,0 +1,75 @@
+/*
+ *  PUCharge.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Estimates the PU battery charge state from the recent PU status history.
+ *  The charge rate is a least-squares fit of v_battery over the samples taken
+ *  since the PU last docked, and the PU is considered ready once the battery
+ *  reaches the ready voltage, or once the charge current has tapered off (ie.
+ *  the charger has finished) with the battery above the minimum voltage. Used
+ *  to hold a profile until the PU has charged, or to start it early once the
+ *  PU is already full.
+ *
+ *  No Arduino dependencies.
+ */
+
+#ifndef PUCHARGE_H
+#define PUCHARGE_H
+
+#include <stdint.h>
+
+#define PU_CHARGE_HISTORY   8
+#define PU_CHARGE_MIN_SPAN  60  // seconds of history needed for a charge rate
+#define PU_CHARGE_STALE     600 // seconds before the last status is too old to use
+
+// configured charge thresholds
+struct ChargeThresholds_t {
+    float ready_voltage; // ready to profile at or above this voltage
+    float min_voltage;   // never ready below this voltage (brown-out risk)
+    float full_current;  // charge current at or below this means the charger has finished
+};
+
+class PUChargeModel {
+public:
+    PUChargeModel() { };
+    ~PUChargeModel() { };
+
+    // add a valid PU status (invalid statuses with v_battery = 0 are ignored)
+    void AddStatus(uint32_t time, float v_battery, float i_charge);
+
+    // clear the history (the PU isn't charging off the dock)
+    void Reset() { count = 0; head = 0; }
+
+    // battery voltage slope in V/s, false if there isn't enough history
+    bool ChargeRate(float * rate);
+
+    // true if the latest status (not older than PU_CHARGE_STALE) shows the PU is ready
+    bool Ready(uint32_t time, const ChargeThresholds_t & thresholds);
+
+    // seconds from time until the PU is predicted ready, false if it can't be predicted
+    bool SecondsToReady(uint32_t time, const ChargeThresholds_t & thresholds, uint32_t * seconds);
+
+    // true if there's a status recent enough to use
+    bool Fresh(uint32_t time);
+
+    uint8_t Count() { return count; }
+    float Voltage() { return (0 != count) ? Latest().v_battery : 0.0f; }
+    float ChargeCurrent() { return (0 != count) ? Latest().i_charge : 0.0f; }
+
+private:
+    struct ChargeSample_t {
+        uint32_t time;
+        float v_battery;
+        float i_charge;
+    };
+
+    ChargeSample_t & Latest() { return samples[(head + PU_CHARGE_HISTORY - 1) % PU_CHARGE_HISTORY]; }
+    ChargeSample_t & Oldest() { return samples[(head + PU_CHARGE_HISTORY - count) % PU_CHARGE_HISTORY]; }
+
+    ChargeSample_t samples[PU_CHARGE_HISTORY] = {{0}};
+    uint8_t count = 0;
+    uint8_t head = 0; // next index to write
+};
+
+#endif /* PUCHARGE_H */
@@ -0,0 +1,183 @@
+/*
+ *  PUCompress.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Delta + LZ77 compression of PU profile records, and the ground-side decompressor
+ */
+
+#include "PUCompress.h"
+
+#define MIN_MATCH   4
+#define MAX_MATCH   (0x7F + MIN_MATCH)
+#define MAX_LITERAL 0x80
+#define NO_ENTRY    0xFFFF
+
+uint16_t PURecordCompressor::Compress(const uint8_t * record, uint16_t length, uint8_t stride, uint8_t * out, uint16_t out_size)
+{
+    uint16_t used = 0;
+
+    if (out_size < PU_COMPRESS_BOUND(length)) return 0;
+
+    in = record;
+    in_length = length;
+    delta_stride = stride;
+
+    out[0] = PU_COMPRESS_MAGIC;
+    out[1] = PU_COMPRESS_LZ;
+    out[2] = stride;
+    out[3] = (uint8_t) length;
+    out[4] = (uint8_t) (length >> 8);
+
+    // only keep the LZ output if it's smaller than the record
+    used = CompressLZ(out + PU_COMPRESS_HEADER, length);
+    if (0 != used) return PU_COMPRESS_HEADER + used;
+
+    out[1] = PU_COMPRESS_STORED;
+    out[2] = 0;
+    for (uint16_t i = 0; i < length; i++) {
+        out[PU_COMPRESS_HEADER + i] = record[i];
+    }
+
+    return PU_COMPRESS_HEADER + length;
+}
+
+uint16_t PURecordCompressor::Hash(uint16_t i)
+{
+    uint32_t key = Delta(i) | (Delta(i+1) << 8) | ((uint32_t) Delta(i+2) << 16);
+
+    return (uint16_t) ((key * 2654435761u) >> (32 - PU_COMPRESS_HASH_BITS));
+}
+
+// returns 0 if the output won't fit in out_size
+uint16_t PURecordCompressor::CompressLZ(uint8_t * out, uint16_t out_size)
+{
+    uint16_t used = 0;
+    uint16_t literal_start = 0;
+    uint16_t i = 0;
+
+    for (uint16_t h = 0; h < (1 << PU_COMPRESS_HASH_BITS); h++) {
+        table[h] = NO_ENTRY;
+    }
+
+    while ((uint32_t) i + MIN_MATCH <= in_length) {
+        uint16_t hash = Hash(i);
+        uint16_t candidate = table[hash];
+        uint16_t match = 0;
+
+        table[hash] = i;
+
+        if (NO_ENTRY != candidate) {
+            while (match < MAX_MATCH && (uint32_t) i + match < in_length && Delta(candidate + match) == Delta(i + match)) {
+                match++;
+            }
+        }
+
+        if (match < MIN_MATCH) {
+            i++;
+            continue;
+        }
+
+        if (!FlushLiterals(literal_start, i, out, out_size, &used) || used + 3 > out_size) return 0;
+
+        out[used++] = 0x80 | (match - MIN_MATCH);
+        out[used++] = (uint8_t) (i - candidate);
+        out[used++] = (uint8_t) ((i - candidate) >> 8);
+
+        // index the positions inside the match for later references
+        for (uint16_t j = i + 1; j < i + match && (uint32_t) j + MIN_MATCH <= in_length; j++) {
+            table[Hash(j)] = j;
+        }
+
+        i += match;
+        literal_start = i;
+    }
+
+    if (!FlushLiterals(literal_start, in_length, out, out_size, &used)) return 0;
+
+    return (used < out_size) ? used : 0;
+}
+
+bool PURecordCompressor::FlushLiterals(uint16_t start, uint16_t end, uint8_t * out, uint16_t out_size, uint16_t * used)
+{
+    while (start < end) {
+        uint16_t run = end - start;
+        if (run > MAX_LITERAL) run = MAX_LITERAL;
+
+        if (*used + 1 + run > out_size) return false;
+
+        out[(*used)++] = (uint8_t) (run - 1);
+        for (uint16_t i = 0; i < run; i++) {
+            out[(*used)++] = Delta(start + i);
+        }
+
+        start += run;
+    }
+
+    return true;
+}
+
+uint16_t DecompressPURecord(const uint8_t * compressed, uint16_t length, uint8_t * out, uint16_t out_size)
+{
+    uint16_t original = 0;
+    uint8_t stride = 0;
+    uint16_t in = PU_COMPRESS_HEADER;
+    uint16_t used = 0;
+
+    if (length < PU_COMPRESS_HEADER || PU_COMPRESS_MAGIC != compressed[0]) return 0;
+
+    stride = compressed[2];
+    original = compressed[3] | (compressed[4] << 8);
+    if (original > out_size) return 0;
+
+    if (PU_COMPRESS_STORED == compressed[1]) {
+        if (length != PU_COMPRESS_HEADER + original) return 0;
+
+        for (uint16_t i = 0; i < original; i++) {
+            out[i] = compressed[PU_COMPRESS_HEADER + i];
+        }
+        return original;
+    }
+
+    if (PU_COMPRESS_LZ != compressed[1]) return 0;
+
+    while (used < original) {
+        uint8_t control = 0;
+
+        if (in >= length) return 0;
+        control = compressed[in++];
+
+        if (control < 0x80) {
+            uint16_t run = control + 1;
+            if (in + run > length || used + run > original) return 0;
+            for (uint16_t i = 0; i < run; i++) {
+                out[used++] = compressed[in++];
+            }
+        } else {
+            uint16_t match = (control & 0x7F) + MIN_MATCH;
+            uint16_t distance = 0;
+
+            if (in + 2 > length) return 0;
+            distance = compressed[in] | (compressed[in+1] << 8);
+            in += 2;
+
+            if (0 == distance || distance > used || used + match > original) return 0;
+
+            // byte by byte, since a match can overlap its own output
+            for (uint16_t i = 0; i < match; i++, used++) {
+                out[used] = out[used - distance];
+            }
+        }
+    }
+
+    if (in != length) return 0;
+
+    // undo the delta in order, each byte from the already restored one a stride back
+    if (0 != stride) {
+        for (uint16_t i = stride; i < original; i++) {
+            out[i] += out[i - stride];
+        }
+    }
+
+    return original;
+}
@@ -0,0 +1,60 @@
+/*
+ *  PUCompress.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Lossless compression of PU profile records for the downlink. An optional
+ *  byte-wise delta at the record's sample stride turns slowly varying fields
+ *  into runs of small values, and a small LZ77 coder then replaces repeats
+ *  with back-references into the record. The hash table is the only working
+ *  memory (2 KB), and a record that doesn't shrink is stored as is.
+ *
+ *    header:    0xC5, method (0 stored, 1 LZ), stride, original length (u16)
+ *    literals:  control 0x00-0x7F, then control + 1 bytes
+ *    matches:   control 0x80-0xFF for a length of (control & 0x7F) + 4,
+ *               then the distance back (u16)
+ *
+ *  The decompressor is in this file too. This file has no Arduino
+ *  dependencies so that it can be compiled into ground software.
+ */
+
+#ifndef PUCOMPRESS_H
+#define PUCOMPRESS_H
+
+#include <stdint.h>
+
+#define PU_COMPRESS_MAGIC       0xC5
+#define PU_COMPRESS_HEADER      5
+#define PU_COMPRESS_STORED      0
+#define PU_COMPRESS_LZ          1
+#define PU_COMPRESS_HASH_BITS   10
+
+// the most bytes a compressed record can need (stored, with the header)
+#define PU_COMPRESS_BOUND(length)   ((length) + PU_COMPRESS_HEADER)
+
+class PURecordCompressor {
+public:
+    PURecordCompressor() { };
+    ~PURecordCompressor() { };
+
+    // Compress the record into out with a delta at stride (0 for none). Returns the bytes
+    // written, or 0 if out_size is smaller than PU_COMPRESS_BOUND(length).
+    uint16_t Compress(const uint8_t * record, uint16_t length, uint8_t stride, uint8_t * out, uint16_t out_size);
+
+private:
+    uint16_t CompressLZ(uint8_t * out, uint16_t out_size);
+    bool FlushLiterals(uint16_t start, uint16_t end, uint8_t * out, uint16_t out_size, uint16_t * used);
+    uint8_t Delta(uint16_t i) { return (0 != delta_stride && i >= delta_stride) ? in[i] - in[i - delta_stride] : in[i]; }
+    uint16_t Hash(uint16_t i);
+
+    uint16_t table[1 << PU_COMPRESS_HASH_BITS] = {0};
+    const uint8_t * in = 0;
+    uint16_t in_length = 0;
+    uint8_t delta_stride = 0;
+};
+
+// Decompress a record into out. Returns the original length, or 0 if the record is
+// malformed or out_size is too small.
+uint16_t DecompressPURecord(const uint8_t * compressed, uint16_t length, uint8_t * out, uint16_t out_size);
+
+#endif /* PUCOMPRESS_H */
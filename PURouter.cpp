@@ -14,6 +14,7 @@ void StratoPIB::RunPURouter()
 
     while (NO_MESSAGE != rx_msg) {
         PUDock();
+        dockDetector.NoteUART(millis());
         if (ASCII_MESSAGE == rx_msg) {
             HandlePUASCII();
         } else if (ACK_MESSAGE == rx_msg) {
@@ -34,6 +35,7 @@ void StratoPIB::HandlePUASCII()
 {
     switch (puComm.ascii_rx.msg_id) {
     case PU_STATUS:
+        ReliableRequest::AckReceived(REQ_PU_STATUS);
         if (!puComm.ascii_rx.checksum_valid || !puComm.RX_Status(&pu_status.time, &pu_status.v_battery, &pu_status.i_charge, &pu_status.therm1, &pu_status.therm2, &pu_status.heater_stat)) {
             pu_status.time = 0;
             pu_status.v_battery = 0.0f;
@@ -41,11 +43,16 @@ void StratoPIB::HandlePUASCII()
             pu_status.therm1 = 0.0f;
             pu_status.therm2 = 0.0f;
             pu_status.heater_stat = 0;
+            binaryLog.Log(BL_PU_STATUS_INVALID);
         } else {
             pu_status.last_status = now();
+            puCharge.AddStatus(pu_status.last_status, pu_status.v_battery, pu_status.i_charge);
+            binaryLog.Log(BL_PU_STATUS, pu_status.time, pu_status.v_battery, pu_status.i_charge,
+                          pu_status.therm1, pu_status.therm2, pu_status.heater_stat);
         }
         break;
     case PU_NO_MORE_RECORDS:
+        ReliableRequest::AckReceived(REQ_PU_RECORD); // answers the record request
         pu_no_more_records = true;
         break;
     default:
@@ -58,19 +65,24 @@ void StratoPIB::HandlePUAck()
 {
     switch (puComm.ack_id) {
     case PU_GO_WARMUP:
+        ReliableRequest::AckReceived(REQ_PU_WARMUP);
         log_nominal("PU in warmup");
         pu_warmup = true;
         break;
     case PU_GO_PROFILE:
+        ReliableRequest::AckReceived(REQ_PU_PROFILE);
         log_nominal("PU in profile");
         pu_profile = true;
         break;
     case PU_GO_PREPROFILE:
+        ReliableRequest::AckReceived(REQ_PU_PREPROFILE);
         log_nominal("PU in preprofile");
         pu_preprofile = true;
         break;
     case PU_RESET:
+        ReliableRequest::AckReceived(REQ_PU_RESET);
         ZephyrLogFine("PU acked reset");
+        pu_reset = true;
         break;
     default:
         log_error("Unknown PU ack received");
@@ -83,6 +95,8 @@ void StratoPIB::HandlePUBin()
     // can handle all PU TM receipt here with ACKs/NAKs and tm_finished + buffer_ready flags
     switch (puComm.binary_rx.bin_id) {
     case PU_TSEN_RECORD:
+        ReliableRequest::AckReceived(REQ_PU_TSEN);
+
         // prep the TM buffer
         zephyrTX.clearTm();
 
@@ -98,11 +112,13 @@ void StratoPIB::HandlePUBin()
         break;
 
     case PU_PROFILE_RECORD:
+        ReliableRequest::AckReceived(REQ_PU_RECORD);
+
         // prep the TM buffer
         zephyrTX.clearTm();
 
         // see if we can place in the buffer
-        if (puComm.binary_rx.checksum_valid && zephyrTX.addTm(puComm.binary_rx.bin_buffer, puComm.binary_rx.bin_length)) {
+        if (puComm.binary_rx.checksum_valid && AddPURecordTM(puComm.binary_rx.bin_buffer, puComm.binary_rx.bin_length)) {
             record_received = true;
             puComm.TX_Ack(PU_TSEN_RECORD, true);
         } else {
@@ -118,6 +134,23 @@ void StratoPIB::HandlePUBin()
     }
 }
 
+bool StratoPIB::AddPURecordTM(const uint8_t * record, uint16_t record_length)
+{
+    uint32_t start = micros();
+    uint16_t length = 0;
+
+    if (!pibConfigs.compress_pu.Read()) {
+        return zephyrTX.addTm(record, record_length);
+    }
+
+    length = puCompressor.Compress(record, record_length, pibConfigs.pu_delta_stride.Read(), pu_compressed, sizeof(pu_compressed));
+    if (0 == length) return false;
+
+    binaryLog.Log(BL_PU_COMPRESSED, record_length, length, micros() - start);
+
+    return zephyrTX.addTm(pu_compressed, length);
+}
+
 void StratoPIB::HandlePUString()
 {
     switch (puComm.string_rx.str_id) {
@@ -0,0 +1,70 @@
+/*
+ *  ProfilePlanner.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Plans the night's profile start times
+ */
+
+#include "ProfilePlanner.h"
+
+uint32_t ProfilePlanner::MotionSeconds(const ProfileDurations_t & durations)
+{
+    return durations.ra + durations.warmup + durations.tsen + durations.preprofile + durations.deploy
+         + durations.dwell + durations.retract + durations.dock_wait + durations.dock;
+}
+
+uint32_t ProfilePlanner::ProfileSeconds(const ProfileDurations_t & durations)
+{
+    return MotionSeconds(durations) + durations.offload;
+}
+
+uint8_t ProfilePlanner::Plan(uint32_t start, uint32_t window_end_time, uint8_t max_profiles, uint32_t min_spacing,
+                             const ProfileDurations_t & durations)
+{
+    uint32_t motion_seconds = MotionSeconds(durations);
+    uint32_t spacing = 0;
+
+    profile_seconds = ProfileSeconds(durations);
+    window_end = window_end_time;
+    period = min_spacing;
+    spacing = (period > profile_seconds) ? period : profile_seconds;
+
+    count = 0;
+    next = 0;
+    truncated = false;
+
+    // the window decides how many fit, max_profiles only applies without one
+    while (0 != window_end || count < max_profiles) {
+        uint32_t profile_start = start + count * spacing;
+
+        // the motion (not the offload) has to finish in the dark
+        if (0 != window_end && profile_start + motion_seconds > window_end) break;
+
+        if (PLAN_MAX_PROFILES == count) {
+            truncated = true;
+            break;
+        }
+
+        starts[count++] = profile_start;
+    }
+
+    return count;
+}
+
+bool ProfilePlanner::ProfileFinished(uint32_t time)
+{
+    if (next >= count) return false;
+
+    uint32_t planned_end = starts[next++] + profile_seconds;
+
+    return time > planned_end + PLAN_LATE_MARGIN;
+}
+
+bool ProfilePlanner::NextStart(uint32_t time, uint32_t * seconds)
+{
+    if (next >= count) return false;
+
+    *seconds = (starts[next] > time) ? starts[next] - time : 0;
+    return true;
+}
@@ -0,0 +1,82 @@
+/*
+ *  ProfilePlanner.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Plans the night's profile start times from a per-profile duration model
+ *  and the dark window (until the morning SZA crossing). Profiles are packed
+ *  back to back at the modeled duration, or no closer than an optional minimum
+ *  spacing, and as many are planned as have their motion finish before the
+ *  end of the window. Without a window, a maximum number is planned instead.
+ *  A plan that reaches PLAN_MAX_PROFILES is flagged as truncated. Only the
+ *  next profile is scheduled at a time, so the rest of the plan can be redone
+ *  if a profile runs long.
+ *
+ *  No Arduino dependencies.
+ */
+
+#ifndef PROFILEPLANNER_H
+#define PROFILEPLANNER_H
+
+#include <stdint.h>
+
+#define PLAN_MAX_PROFILES   24
+#define PLAN_START_DELAY    5   // seconds before the first profile
+#define PLAN_LATE_MARGIN    300 // seconds past the planned end before re-planning
+
+// modeled length of each profile step (seconds)
+struct ProfileDurations_t {
+    uint32_t ra;
+    uint32_t warmup;
+    uint32_t tsen;
+    uint32_t preprofile;
+    uint32_t deploy;
+    uint32_t dwell;
+    uint32_t retract;
+    uint32_t dock_wait;
+    uint32_t dock;
+    uint32_t offload;
+};
+
+class ProfilePlanner {
+public:
+    ProfilePlanner() { };
+    ~ProfilePlanner() { };
+
+    // from the RA until the PU is docked
+    static uint32_t MotionSeconds(const ProfileDurations_t & durations);
+
+    // the full profile including the PU offload
+    static uint32_t ProfileSeconds(const ProfileDurations_t & durations);
+
+    // Plan from start as many profiles as fit before window_end, or max_profiles if window_end is 0,
+    // spaced at least min_spacing apart (0 for none). Returns the number planned.
+    uint8_t Plan(uint32_t start, uint32_t window_end, uint8_t max_profiles, uint32_t min_spacing, const ProfileDurations_t & durations);
+
+    // note the end of the next planned profile, true if it ended late enough to re-plan
+    bool ProfileFinished(uint32_t time);
+
+    // seconds from time until the next planned start (0 if it's due), false if none remain
+    bool NextStart(uint32_t time, uint32_t * seconds);
+
+    uint8_t Count() { return count; }
+    uint8_t Remaining() { return count - next; }
+    uint32_t Start(uint8_t index) { return (index < count) ? starts[index] : 0; }
+    uint32_t WindowEnd() { return window_end; }
+    uint32_t Period() { return period; }
+    uint32_t Duration() { return profile_seconds; }
+
+    // true if more profiles fit in the window than PLAN_MAX_PROFILES
+    bool Truncated() { return truncated; }
+
+private:
+    uint32_t starts[PLAN_MAX_PROFILES] = {0};
+    uint32_t window_end = 0;
+    uint32_t period = 0;
+    uint32_t profile_seconds = 0;
+    uint8_t count = 0;
+    uint8_t next = 0;
+    bool truncated = false;
+};
+
+#endif /* PROFILEPLANNER_H */
@@ -0,0 +1,65 @@
+/*
+ *  ProfileTable.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  The profile plan table: a list of profile specifications uploaded by
+ *  telecommand and stored in EEPROM (see PIBConfigs). With plan mode set,
+ *  autonomous flight steps through the table in order, applying each entry's
+ *  parameters when its trigger fires, so that a night can mix deep and
+ *  shallow, slow and fast, and docked profiles without reconfiguring between
+ *  them.
+ *
+ *  Triggers:
+ *    PLAN_TRIGGER_SZA   = the SZA trigger (as for num_profiles, incl. prediction)
+ *    PLAN_TRIGGER_TIME  = trigger_value is a UTC time (seconds since epoch)
+ *    PLAN_TRIGGER_AFTER = trigger_value seconds after the previous entry ends
+ *
+ *  No Arduino dependencies.
+ */
+
+#ifndef PROFILETABLE_H
+#define PROFILETABLE_H
+
+#include <stdint.h>
+
+#define PROFILE_TABLE_SIZE  8
+
+enum PlanEntryType_t : uint8_t {
+    PLAN_EMPTY,
+    PLAN_PROFILE,
+    PLAN_DOCKED,
+    NUM_PLAN_TYPES
+};
+
+enum PlanTrigger_t : uint8_t {
+    PLAN_TRIGGER_SZA,
+    PLAN_TRIGGER_TIME,
+    PLAN_TRIGGER_AFTER,
+    NUM_PLAN_TRIGGERS
+};
+
+// PU instrument enable bits
+#define PLAN_ENABLE_TSEN    0x01
+#define PLAN_ENABLE_ROPC    0x02
+#define PLAN_ENABLE_FLASH   0x04
+
+struct ProfileSpec_t {
+    uint8_t type;           // PlanEntryType_t
+    uint8_t trigger;        // PlanTrigger_t
+    uint8_t enables;        // PLAN_ENABLE_* bits
+    uint32_t trigger_value;
+    float profile_size;     // revs (unused when docked)
+    float deploy_velocity;  // rpm (unused when docked)
+    float retract_velocity; // rpm (unused when docked)
+    uint16_t dwell_time;    // seconds, or the docked profile duration
+    uint32_t profile_rate;  // PU rate while profiling (or docked)
+    uint32_t dwell_rate;    // PU rate during the dwell (unused when docked)
+};
+
+struct ProfileTable_t {
+    uint8_t count;
+    ProfileSpec_t entries[PROFILE_TABLE_SIZE];
+};
+
+#endif /* PROFILETABLE_H */
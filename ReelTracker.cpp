@@ -0,0 +1,62 @@
+/*
+ *  ReelTracker.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Tracks the reel position and velocity from the MCB motion TM
+ */
+
+#include "ReelTracker.h"
+
+void ReelTracker::Restore(float revolutions)
+{
+    position = revolutions;
+    target = revolutions;
+    velocity = 0.0f;
+    valid = true;
+}
+
+void ReelTracker::Update(uint32_t time_ms, float revolutions)
+{
+    uint32_t elapsed = time_ms - last_update;
+
+    // only estimate the velocity from consecutive frames within a motion
+    if (valid && tm_since_command && 0 != elapsed) {
+        float sample = 60000.0f * (revolutions - position) / elapsed;
+        velocity += REEL_VELOCITY_GAIN * (sample - velocity);
+    }
+
+    position = revolutions;
+    last_update = time_ms;
+    tm_since_command = true;
+    valid = true;
+}
+
+void ReelTracker::MotionCommanded(float revs)
+{
+    target = position + revs;
+    velocity = 0.0f;
+    moving = true;
+    tm_since_command = false;
+}
+
+void ReelTracker::MotionEnded(bool completed)
+{
+    if (!moving) return;
+
+    // dead reckon from the command if the MCB sent no TM
+    if (completed && !tm_since_command && valid) {
+        position = target;
+    }
+
+    velocity = 0.0f;
+    moving = false;
+}
+
+void ReelTracker::Zero()
+{
+    position = 0.0f;
+    target = 0.0f;
+    velocity = 0.0f;
+    valid = true;
+}
@@ -0,0 +1,58 @@
+/*
+ *  ReelTracker.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Tracks the reel position (revolutions from the zeroed dock position,
+ *  positive paid out) and velocity from the MCB motion TM. Between frames,
+ *  and if no TM arrives during a motion, the commanded motion is used: a
+ *  motion that finishes without any TM is assumed to have reached its
+ *  commanded end. The position is saved to EEPROM by the owner at the end of
+ *  each motion, so it can be restored after a reset.
+ *
+ *  No Arduino dependencies.
+ */
+
+#ifndef REELTRACKER_H
+#define REELTRACKER_H
+
+#include <stdint.h>
+
+#define REEL_VELOCITY_GAIN  0.5f // weight of each new velocity sample
+
+class ReelTracker {
+public:
+    ReelTracker() { };
+    ~ReelTracker() { };
+
+    // position saved before a reset
+    void Restore(float revolutions);
+
+    // reel position from an MCB motion TM frame
+    void Update(uint32_t time_ms, float revolutions);
+
+    // a motion of revs was commanded (negative for reeling in)
+    void MotionCommanded(float revs);
+
+    // the motion ended, completed = false for a fault or cancel
+    void MotionEnded(bool completed);
+
+    // the MCB zeroed the reel at the dock
+    void Zero();
+
+    bool Valid() { return valid; }
+    float Position() { return position; }
+    float Velocity() { return velocity; } // rpm, positive paying out
+    float Target() { return target; }
+
+private:
+    float position = 0.0f;
+    float velocity = 0.0f;
+    float target = 0.0f;
+    uint32_t last_update = 0; // ms
+    bool valid = false;
+    bool moving = false;
+    bool tm_since_command = false;
+};
+
+#endif /* REELTRACKER_H */
@@ -0,0 +1,176 @@
+/*
+ *  ReliableRequest.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Send-confirm-retry bookkeeping for requests to the MCB, PU, and Zephyr
+ */
+
+#include "ReliableRequest.h"
+#include "Arduino.h"
+
+// target of each request type, indexed by RequestID_t
+static const RequestTarget_t request_targets[NUM_REQUEST_IDS] = {
+    /* REQ_NONE          */ TARGET_MCB,
+    /* REQ_RA            */ TARGET_ZEPHYR,
+    /* REQ_TM            */ TARGET_ZEPHYR,
+    /* REQ_MCB_MOTION    */ TARGET_MCB,
+    /* REQ_MCB_LOW_POWER */ TARGET_MCB,
+    /* REQ_PU_STATUS     */ TARGET_PU,
+    /* REQ_PU_WARMUP     */ TARGET_PU,
+    /* REQ_PU_PROFILE    */ TARGET_PU,
+    /* REQ_PU_PREPROFILE */ TARGET_PU,
+    /* REQ_PU_TSEN       */ TARGET_PU,
+    /* REQ_PU_RECORD     */ TARGET_PU,
+    /* REQ_PU_RESET      */ TARGET_PU,
+};
+
+// one retry and REQUEST_DEFAULT_RTO until configured and measured
+uint8_t ReliableRequest::retries[NUM_REQUEST_TARGETS] = {1, 1, 1};
+uint32_t ReliableRequest::rto_min[NUM_REQUEST_TARGETS] = {1000, 1000, 1000};
+uint32_t ReliableRequest::rto_max[NUM_REQUEST_TARGETS] = {60000, 60000, 60000};
+uint32_t ReliableRequest::last_ack[NUM_REQUEST_IDS] = {0};
+RTTEstimate_t ReliableRequest::estimates[NUM_REQUEST_IDS] = {{0}};
+RequestStats_t ReliableRequest::stats[NUM_REQUEST_IDS] = {{0}};
+
+void ReliableRequest::Start(RequestID_t request_id)
+{
+    id = (request_id < NUM_REQUEST_IDS) ? request_id : REQ_NONE;
+    attempt = 0;
+    sent_time = millis();
+    active = (REQ_NONE != id);
+}
+
+void ReliableRequest::Sent()
+{
+    sent_time = millis();
+}
+
+uint32_t ReliableRequest::AttemptTimeout()
+{
+    uint32_t base = (0 != estimates[id].rto) ? estimates[id].rto : REQUEST_DEFAULT_RTO;
+    uint8_t shift = (attempt < REQUEST_MAX_BACKOFF_SHIFT) ? attempt : REQUEST_MAX_BACKOFF_SHIFT;
+
+    return (base << shift) + (uint32_t) random(base / REQUEST_JITTER_DIVISOR + 1);
+}
+
+void ReliableRequest::Complete()
+{
+    if (!active) return;
+
+    RequestStats_t & request_stats = stats[id];
+    uint32_t rtt = millis() - sent_time;
+
+    // use the router's timestamp if the reply arrived after the attempt was sent
+    if (last_ack[id] - sent_time <= rtt) {
+        rtt = last_ack[id] - sent_time;
+    }
+
+    // Karn's algorithm: a retried request's ack could be for any attempt
+    if (0 == attempt) UpdateEstimate(id, rtt);
+
+    if (0 == request_stats.completed || rtt < request_stats.rtt_min) request_stats.rtt_min = rtt;
+    if (rtt > request_stats.rtt_max) request_stats.rtt_max = rtt;
+    request_stats.rtt_total += rtt;
+    request_stats.completed++;
+
+    active = false;
+}
+
+bool ReliableRequest::Retry()
+{
+    if (!active) return false;
+
+    if (attempt < retries[request_targets[id]]) {
+        attempt++;
+        stats[id].retries++;
+        return true;
+    }
+
+    stats[id].failed++;
+    active = false;
+    return false;
+}
+
+void ReliableRequest::UpdateEstimate(RequestID_t request_id, uint32_t rtt)
+{
+    RTTEstimate_t & estimate = estimates[request_id];
+    uint32_t deviation = 0;
+
+    if (0 == estimate.samples) {
+        estimate.srtt = rtt;
+        estimate.rttvar = rtt / 2;
+    } else {
+        deviation = (estimate.srtt > rtt) ? estimate.srtt - rtt : rtt - estimate.srtt;
+        estimate.rttvar = (3 * estimate.rttvar + deviation) / 4;
+        estimate.srtt = (7 * estimate.srtt + rtt) / 8;
+    }
+
+    if (estimate.samples < UINT16_MAX) estimate.samples++;
+
+    estimate.rto = estimate.srtt + 4 * estimate.rttvar;
+    ClampEstimate(request_id);
+}
+
+void ReliableRequest::ClampEstimate(RequestID_t request_id)
+{
+    RTTEstimate_t & estimate = estimates[request_id];
+    RequestTarget_t target = request_targets[request_id];
+
+    if (estimate.rto < rto_min[target]) estimate.rto = rto_min[target];
+    if (estimate.rto > rto_max[target]) estimate.rto = rto_max[target];
+}
+
+void ReliableRequest::AckReceived(RequestID_t request_id)
+{
+    if (REQ_NONE != request_id && request_id < NUM_REQUEST_IDS) last_ack[request_id] = millis();
+}
+
+void ReliableRequest::SetRetries(RequestTarget_t target, uint8_t num_retries)
+{
+    if (target < NUM_REQUEST_TARGETS) retries[target] = num_retries;
+}
+
+void ReliableRequest::SetTimeoutBounds(RequestTarget_t target, uint16_t min_seconds, uint16_t max_seconds)
+{
+    if (target >= NUM_REQUEST_TARGETS || min_seconds > max_seconds) return;
+
+    rto_min[target] = 1000 * (uint32_t) min_seconds;
+    rto_max[target] = 1000 * (uint32_t) max_seconds;
+
+    // apply the bounds to the current estimates
+    for (uint8_t i = REQ_NONE + 1; i < NUM_REQUEST_IDS; i++) {
+        if (target == request_targets[i] && 0 != estimates[i].rto) ClampEstimate((RequestID_t) i);
+    }
+}
+
+uint8_t ReliableRequest::Retries(RequestID_t request_id)
+{
+    return retries[Target(request_id)];
+}
+
+RequestTarget_t ReliableRequest::Target(RequestID_t request_id)
+{
+    return (request_id < NUM_REQUEST_IDS) ? request_targets[request_id] : TARGET_MCB;
+}
+
+void ReliableRequest::SetInitialTimeout(RequestTarget_t target, uint16_t seconds)
+{
+    if (target >= NUM_REQUEST_TARGETS) return;
+
+    for (uint8_t i = REQ_NONE + 1; i < NUM_REQUEST_IDS; i++) {
+        if (target == request_targets[i] && 0 == estimates[i].samples) {
+            estimates[i].rto = 1000 * (uint32_t) seconds;
+        }
+    }
+}
+
+const RTTEstimate_t & ReliableRequest::Estimate(RequestID_t request_id)
+{
+    return estimates[(request_id < NUM_REQUEST_IDS) ? request_id : REQ_NONE];
+}
+
+const RequestStats_t & ReliableRequest::Stats(RequestID_t request_id)
+{
+    return stats[(request_id < NUM_REQUEST_IDS) ? request_id : REQ_NONE];
+}
@@ -0,0 +1,129 @@
+/*
+ *  ReliableRequest.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Send-confirm-retry bookkeeping for requests to the MCB, PU, and Zephyr.
+ *
+ *  Retry counts are set per target. The first attempt waits for the target's
+ *  retransmission timeout (RTO), and each retry waits twice as long as the
+ *  previous one (up to REQUEST_MAX_BACKOFF_SHIFT doublings) plus a random
+ *  jitter. A request completes as soon as its ack is seen. Round-trip times
+ *  are accumulated per request type.
+ *
+ *  The RTO adapts to each request type like TCP (RFC 6298): a smoothed RTT
+ *  and RTT variance are updated from every request that completes on its
+ *  first attempt (retried requests are ambiguous and skipped), and
+ *  RTO = SRTT + 4 * RTTVAR, clamped to the target's configured bounds. Each
+ *  request type keeps its own estimate, since ie. an RA and a TM ack from
+ *  Zephyr take very different times. The MCB and PU routers timestamp the
+ *  reply to each request type as it arrives with AckReceived(), otherwise the
+ *  round trip ends when the ack flag is seen (ie. for Zephyr).
+ *
+ *  States in a PIBStateMachine table that name a request id use this for
+ *  their timeouts and retries (see PIBStateMachine.h).
+ */
+
+#ifndef RELIABLEREQUEST_H
+#define RELIABLEREQUEST_H
+
+#include <stdint.h>
+
+#define REQUEST_MAX_BACKOFF_SHIFT   2
+#define REQUEST_JITTER_DIVISOR      8 // max jitter is the base timeout / 8
+#define REQUEST_DEFAULT_RTO         10000 // ms, until configured and measured
+
+enum RequestTarget_t : uint8_t {
+    TARGET_MCB,
+    TARGET_PU,
+    TARGET_ZEPHYR,
+    NUM_REQUEST_TARGETS
+};
+
+enum RequestID_t : uint8_t {
+    REQ_NONE = 0,
+    REQ_RA,
+    REQ_TM,
+    REQ_MCB_MOTION,
+    REQ_MCB_LOW_POWER,
+    REQ_PU_STATUS,
+    REQ_PU_WARMUP,
+    REQ_PU_PROFILE,
+    REQ_PU_PREPROFILE,
+    REQ_PU_TSEN,
+    REQ_PU_RECORD,
+    REQ_PU_RESET,
+    NUM_REQUEST_IDS
+};
+
+struct RTTEstimate_t {
+    uint32_t srtt;    // ms
+    uint32_t rttvar;  // ms
+    uint32_t rto;     // ms
+    uint16_t samples;
+};
+
+struct RequestStats_t {
+    uint16_t completed;
+    uint16_t failed;
+    uint16_t retries;
+    uint32_t rtt_min;   // ms
+    uint32_t rtt_max;   // ms
+    uint32_t rtt_total; // ms, divide by completed for the mean
+};
+
+class ReliableRequest {
+public:
+    ReliableRequest() { };
+    ~ReliableRequest() { };
+
+    // begin a new request, nothing is timed until Sent()
+    void Start(RequestID_t request_id);
+
+    // an attempt was just sent, time it from now
+    void Sent();
+
+    // ms to wait for the ack of the current attempt, including backoff and jitter
+    uint32_t AttemptTimeout();
+
+    // the ack was seen, record the round trip of the latest attempt
+    void Complete();
+
+    // the current attempt failed, true if another is allowed (otherwise records a failure)
+    bool Retry();
+
+    // abandoned without a result
+    void Cancel() { active = false; }
+
+    bool Active() { return active; }
+    uint8_t Attempt() { return attempt; }
+
+    // timestamp the reply to a request type as it arrives
+    static void AckReceived(RequestID_t request_id);
+
+    static void SetRetries(RequestTarget_t target, uint8_t num_retries);
+    static void SetTimeoutBounds(RequestTarget_t target, uint16_t min_seconds, uint16_t max_seconds);
+    static void SetInitialTimeout(RequestTarget_t target, uint16_t seconds); // until the first sample
+    static uint8_t Retries(RequestID_t request_id);
+    static RequestTarget_t Target(RequestID_t request_id);
+    static const RequestStats_t & Stats(RequestID_t request_id);
+    static const RTTEstimate_t & Estimate(RequestID_t request_id);
+
+private:
+    static void UpdateEstimate(RequestID_t request_id, uint32_t rtt);
+    static void ClampEstimate(RequestID_t request_id);
+
+    RequestID_t id = REQ_NONE;
+    uint8_t attempt = 0;
+    uint32_t sent_time = 0;
+    bool active = false;
+
+    static uint8_t retries[NUM_REQUEST_TARGETS];
+    static uint32_t rto_min[NUM_REQUEST_TARGETS]; // ms
+    static uint32_t rto_max[NUM_REQUEST_TARGETS]; // ms
+    static uint32_t last_ack[NUM_REQUEST_IDS];
+    static RTTEstimate_t estimates[NUM_REQUEST_IDS];
+    static RequestStats_t stats[NUM_REQUEST_IDS];
+};
+
+#endif /* RELIABLEREQUEST_H */
@@ -0,0 +1,110 @@
+/*
+ *  SDWriter.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  RAM-buffered SD card writer
+ */
+
+#include "SDWriter.h"
+#include <string.h>
+
+bool SDWriter::Queue(uint8_t source, const uint8_t * header, uint16_t header_length,
+                     const uint8_t * payload, uint16_t payload_length)
+{
+    uint8_t record_header[SD_WRITER_HEADER] = {0};
+    uint32_t length = (uint32_t) header_length + payload_length;
+
+    if (length > UINT16_MAX || SD_WRITER_HEADER + length > (uint32_t) (SD_WRITER_SIZE - used)) {
+        stats.dropped++;
+        stats.dropped_bytes += SD_WRITER_HEADER + length;
+        return false;
+    }
+
+    record_header[0] = SD_WRITER_SYNC;
+    record_header[1] = source;
+    record_header[2] = (uint8_t) length;
+    record_header[3] = (uint8_t) (length >> 8);
+
+    Put(record_header, SD_WRITER_HEADER);
+    Put(header, header_length);
+    Put(payload, payload_length);
+
+    stats.queued++;
+    if (used > stats.high_water) stats.high_water = used;
+
+    return true;
+}
+
+void SDWriter::Put(const uint8_t * data, uint16_t length)
+{
+    uint16_t first = 0;
+
+    if (0 == length) return;
+
+    // copy up to the end of the ring, then wrap
+    first = SD_WRITER_SIZE - head;
+    if (first > length) first = length;
+
+    memcpy(ring + head, data, first);
+    memcpy(ring, data + first, length - first);
+
+    head = (head + length) % SD_WRITER_SIZE;
+    used += length;
+}
+
+uint16_t SDWriter::Service(uint32_t time_ms)
+{
+    uint16_t chunk = (used > SD_WRITER_SIZE / 2) ? SD_WRITER_BURST : SD_WRITER_CHUNK;
+    uint16_t written = 0;
+
+    // flush once drained rather than on every chunk
+    if (0 == used) {
+        if (unflushed) {
+            file.flush();
+            unflushed = false;
+        }
+        return 0;
+    }
+
+    if (retrying && time_ms - retry_start < SD_WRITER_RETRY_MS) return 0;
+    retrying = false;
+
+    if (!file_open) {
+        file = SD.open(filename, FILE_WRITE);
+        if (!file) {
+            stats.errors++;
+            retrying = true;
+            retry_start = time_ms;
+            return 0;
+        }
+        file_open = true;
+    }
+
+    // one contiguous piece of the ring per call
+    if (chunk > used) chunk = used;
+    if (chunk > SD_WRITER_SIZE - tail) chunk = SD_WRITER_SIZE - tail;
+
+    written = file.write(ring + tail, chunk);
+
+    tail = (tail + written) % SD_WRITER_SIZE;
+    used -= written;
+    stats.written += written;
+    unflushed = true;
+
+    if (written != chunk) {
+        stats.errors++;
+        Close();
+        retrying = true;
+        retry_start = time_ms;
+    }
+
+    return written;
+}
+
+void SDWriter::Close()
+{
+    if (file_open) file.close();
+    file_open = false;
+    unflushed = false;
+}
@@ -0,0 +1,75 @@
+/*
+ *  SDWriter.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  RAM-buffered SD card writer that keeps SD latency off the TM hot path.
+ *  Records are copied into a ring buffer when queued, and the loop writes
+ *  them out a bounded chunk at a time (SD_WRITER_CHUNK, or SD_WRITER_BURST
+ *  while the ring is over half full). The file is flushed once the ring
+ *  drains, so that a power loss costs at most the data still in RAM.
+ *
+ *    record:  0x5B, source (u8), payload length (u16), then the payload
+ *
+ *  A record that doesn't fit in the ring is refused whole and counted, rather
+ *  than blocking the caller or tearing a record already queued. A failed
+ *  open or write closes the file and retries after SD_WRITER_RETRY_MS.
+ */
+
+#ifndef SDWRITER_H
+#define SDWRITER_H
+
+#include <SD.h>
+#include <stdint.h>
+
+#define SD_WRITER_SIZE      16384   // bytes of RAM for queued records
+#define SD_WRITER_CHUNK     512     // bytes written per call (one SD block)
+#define SD_WRITER_BURST     2048    // bytes written per call while over half full
+#define SD_WRITER_RETRY_MS  5000
+#define SD_WRITER_SYNC      0x5B
+#define SD_WRITER_HEADER    4
+
+struct SDWriterStats_t {
+    uint32_t queued;        // records
+    uint32_t dropped;       // records refused for lack of space
+    uint32_t dropped_bytes;
+    uint32_t written;       // bytes
+    uint16_t errors;        // failed opens and writes
+    uint16_t high_water;    // most bytes queued at once
+};
+
+class SDWriter {
+public:
+    SDWriter(const char * filename) : filename(filename) { };
+    ~SDWriter() { };
+
+    // copy a record of header then payload into the ring, false if it doesn't fit
+    bool Queue(uint8_t source, const uint8_t * header, uint16_t header_length,
+               const uint8_t * payload, uint16_t payload_length);
+
+    // write at most one chunk of queued data, returns the bytes written
+    uint16_t Service(uint32_t time_ms);
+
+    uint16_t Queued() { return used; }
+    const SDWriterStats_t & Stats() { return stats; }
+
+private:
+    void Put(const uint8_t * data, uint16_t length);
+    void Close();
+
+    const char * filename;
+    File file;
+    bool file_open = false;
+    bool unflushed = false;
+    bool retrying = false;
+    uint32_t retry_start = 0; // ms
+
+    uint8_t ring[SD_WRITER_SIZE] = {0};
+    uint16_t head = 0; // next byte to queue
+    uint16_t tail = 0; // next byte to write
+    uint16_t used = 0;
+
+    SDWriterStats_t stats = {0};
+};
+
+#endif /* SDWRITER_H */
@@ -60,7 +60,8 @@ void StratoPIB::SafetyMode()
     case SA_MONITOR_FULL_RETRACT:
         if (!mcb_motion_ongoing) {
             log_nominal("MCB full retract appears complete");
-            dock_length = 200; // go for it -- if we're further than 200 away, something bigger is wrong
+            // go for it -- if we're further than SAFETY_DOCK_LENGTH away, something bigger is wrong
+            dock_length = DockRevs(SAFETY_DOCK_LENGTH, SAFETY_DOCK_LENGTH);
             inst_substate = SA_COMMAND_DOCK;
         }
         break;
@@ -123,7 +124,7 @@ void StratoPIB::SafetyMode()
         break;
 
     case SA_ACK_WAIT:
-        log_debug("Waiting on safety ack");
+        PIB_LOG_DEBUG_LIMITED("Waiting on safety ack");
         // check if the ack has been received
         if (S_ack_flag == ACK) {
             // clear the ack flag and go to the loop
@@ -143,12 +144,12 @@ void StratoPIB::SafetyMode()
 
     case SA_LOOP:
         // nominal ops
-        log_debug("SA loop");
+        PIB_LOG_DEBUG_LIMITED("SA loop");
         digitalWrite(SAFE_PIN, HIGH);
         break;
 
     case SA_ERROR_LANDING:
-        log_debug("SA error");
+        PIB_LOG_DEBUG_LIMITED("SA error");
         break;
 
     case SA_SHUTDOWN:
@@ -0,0 +1,102 @@
+/*
+ *  SolarPosition.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Onboard solar position from the NOAA solar calculator equations
+ */
+
+#include "SolarPosition.h"
+#include <math.h>
+
+#define DEG_TO_RADIANS(x)   ((x) * M_PI / 180.0)
+#define RAD_TO_DEGREES(x)   ((x) * 180.0 / M_PI)
+
+#define SECONDS_PER_DAY     86400UL
+#define MINUTES_PER_DAY     1440.0
+
+// iterations of the crossing prediction, the declination barely moves after the first
+#define CROSSING_ITERATIONS 3
+
+struct SunAngles_t {
+    double declination; // radians
+    double eq_of_time;  // minutes
+};
+
+static SunAngles_t SunAngles(uint32_t utc)
+{
+    SunAngles_t angles;
+
+    // Julian century (double precision is needed for the Julian day)
+    double julian_day = utc / (double) SECONDS_PER_DAY + 2440587.5;
+    double t = (julian_day - 2451545.0) / 36525.0;
+
+    double mean_long = fmod(280.46646 + t * (36000.76983 + t * 0.0003032), 360.0); // degrees
+    double mean_anom = 357.52911 + t * (35999.05029 - 0.0001537 * t); // degrees
+    double eccent = 0.016708634 - t * (0.000042037 + 0.0000001267 * t);
+
+    double center = sin(DEG_TO_RADIANS(mean_anom)) * (1.914602 - t * (0.004817 + 0.000014 * t))
+                  + sin(DEG_TO_RADIANS(2 * mean_anom)) * (0.019993 - 0.000101 * t)
+                  + sin(DEG_TO_RADIANS(3 * mean_anom)) * 0.000289;
+
+    double omega = DEG_TO_RADIANS(125.04 - 1934.136 * t);
+    double app_long = DEG_TO_RADIANS(mean_long + center - 0.00569 - 0.00478 * sin(omega));
+
+    double obliq = 23.0 + (26.0 + (21.448 - t * (46.815 + t * (0.00059 - t * 0.001813))) / 60.0) / 60.0;
+    obliq = DEG_TO_RADIANS(obliq + 0.00256 * cos(omega));
+
+    angles.declination = asin(sin(obliq) * sin(app_long));
+
+    double y = tan(obliq / 2) * tan(obliq / 2);
+    double l0 = DEG_TO_RADIANS(mean_long);
+    double m = DEG_TO_RADIANS(mean_anom);
+
+    angles.eq_of_time = 4.0 * RAD_TO_DEGREES(y * sin(2 * l0) - 2 * eccent * sin(m) + 4 * eccent * y * sin(m) * cos(2 * l0)
+                                            - 0.5 * y * y * sin(4 * l0) - 1.25 * eccent * eccent * sin(2 * m));
+
+    return angles;
+}
+
+float SolarZenithAngle(uint32_t utc, float latitude, float longitude)
+{
+    SunAngles_t angles = SunAngles(utc);
+    double lat = DEG_TO_RADIANS(latitude);
+
+    // true solar time in minutes, then hour angle in degrees
+    double solar_time = fmod((utc % SECONDS_PER_DAY) / 60.0 + angles.eq_of_time + 4.0 * longitude, MINUTES_PER_DAY);
+    double hour_angle = DEG_TO_RADIANS(solar_time / 4.0 - 180.0);
+
+    double cos_zenith = sin(lat) * sin(angles.declination) + cos(lat) * cos(angles.declination) * cos(hour_angle);
+    if (cos_zenith > 1.0) cos_zenith = 1.0;
+    if (cos_zenith < -1.0) cos_zenith = -1.0;
+
+    return (float) RAD_TO_DEGREES(acos(cos_zenith));
+}
+
+uint32_t PredictSZACrossing(uint32_t utc, float latitude, float longitude, float sza, bool rising)
+{
+    uint32_t crossing = utc;
+    double lat = DEG_TO_RADIANS(latitude);
+
+    for (int i = 0; i < CROSSING_ITERATIONS; i++) {
+        SunAngles_t angles = SunAngles(crossing);
+
+        // hour angle at which the sun reaches the zenith angle, positive in the evening
+        double cos_hour_angle = (cos(DEG_TO_RADIANS(sza)) - sin(lat) * sin(angles.declination))
+                              / (cos(lat) * cos(angles.declination));
+        if (cos_hour_angle > 1.0 || cos_hour_angle < -1.0) {
+            return 0; // polar day or night, no crossing
+        }
+
+        double hour_angle = RAD_TO_DEGREES(acos(cos_hour_angle));
+        double solar_time = (rising ? hour_angle : -hour_angle) * 4.0 + 720.0;
+        double utc_minutes = fmod(solar_time - angles.eq_of_time - 4.0 * longitude, MINUTES_PER_DAY);
+        if (utc_minutes < 0) utc_minutes += MINUTES_PER_DAY;
+
+        // the first crossing at or after the start time
+        crossing = utc - (utc % SECONDS_PER_DAY) + (uint32_t) (utc_minutes * 60.0);
+        if (crossing < utc) crossing += SECONDS_PER_DAY;
+    }
+
+    return crossing;
+}
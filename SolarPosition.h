@@ -0,0 +1,27 @@
+/*
+ *  SolarPosition.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Onboard solar position from the NOAA solar calculator equations, used to
+ *  predict when the solar zenith angle (SZA) will cross the profile trigger
+ *  so that the PU warmup can start ahead of it. Accurate to well under a
+ *  degree, which is a few minutes of time at the SZA trigger. Atmospheric
+ *  refraction is ignored since the trigger is below the horizon.
+ *
+ *  No Arduino dependencies, so it can be checked on the ground.
+ */
+
+#ifndef SOLARPOSITION_H
+#define SOLARPOSITION_H
+
+#include <stdint.h>
+
+// solar zenith angle (degrees) at a UTC time (seconds since epoch) and position (degrees, East positive)
+float SolarZenithAngle(uint32_t utc, float latitude, float longitude);
+
+// next time at or after utc (within a day) that the SZA rises through sza (evening) if rising,
+// or falls through it (morning) if not, 0 if it doesn't cross
+uint32_t PredictSZACrossing(uint32_t utc, float latitude, float longitude, float sza, bool rising);
+
+#endif /* SOLARPOSITION_H */
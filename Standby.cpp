@@ -32,7 +32,7 @@ void StratoPIB::StandbyMode()
         break;
     case SB_LOOP:
         // nominal ops
-        log_debug("SB loop");
+        PIB_LOG_DEBUG_LIMITED("SB loop");
 
         // send a mode request if time, and schedule the next
         if (CheckAction(SEND_IMR)) {
@@ -42,7 +42,7 @@ void StratoPIB::StandbyMode()
         }
         break;
     case SB_ERROR_LANDING:
-        log_debug("SB error");
+        PIB_LOG_DEBUG_LIMITED("SB error");
         break;
     case SB_SHUTDOWN:
         // prep for shutdown
@@ -9,11 +9,13 @@
  */
 
 #include "StratoPIB.h"
+#include "Serialize.h"
 
 StratoPIB::StratoPIB()
     : StratoCore(&ZEPHYR_SERIAL, INSTRUMENT, &DEBUG_SERIAL)
     , mcbComm(&MCB_SERIAL)
     , puComm(&PU_SERIAL)
+    , sdWriter(MCB_SD_FILE)
 {
 }
 
@@ -44,12 +46,26 @@ void StratoPIB::InstrumentSetup()
 
     mcbComm.AssignBinaryRXBuffer(binary_mcb, MCB_BUFFER_SIZE);
     puComm.AssignBinaryRXBuffer(binary_pu, PU_BUFFER_SIZE);
+
+    transitionTrace.AttachToStateMachines();
+    ConfigureRequests();
+    ConfigureDrum();
+    ConfigureMotionAnomaly();
+
+    if (pibConfigs.reel_position_valid.Read()) {
+        reelTracker.Restore(pibConfigs.reel_position.Read());
+    }
 }
 
 void StratoPIB::InstrumentLoop()
 {
+    TraceTransitions();
     WatchFlags();
     CheckTSEN();
+
+    // SD writes happen here, a bounded chunk per loop, instead of as TM is sent or records arrive
+    sdWriter.Service(millis());
+    puArchive.Service(millis());
 }
 
 // --------------------------------------------------------
@@ -81,6 +97,7 @@ bool StratoPIB::CheckAction(uint8_t action)
     if (action_flags[action].flag_value) {
         action_flags[action].flag_value = false;
         action_flags[action].stale_count = 0;
+        trace_cause = action;
         return true;
     } else {
         return false;
@@ -107,35 +124,201 @@ void StratoPIB::WatchFlags()
     }
 }
 
+void StratoPIB::QueueCommand(const QueuedCommand_t & command)
+{
+    if (!commandQueue.Push(command)) {
+        snprintf(log_array, LOG_ARRAY_SIZE, "Command queue full, dropped command %u (%u dropped)", command.type, commandQueue.Dropped());
+        ZephyrLogWarn(log_array);
+        return;
+    }
+
+    snprintf(log_array, LOG_ARRAY_SIZE, "Queued command %u, depth %u", command.type, commandQueue.Depth());
+    ZephyrLogFine(log_array);
+
+    // a TSEN offload in manual mode is cut short for the command
+    SetAction(ACTION_OVERRIDE_TSEN);
+}
+
+void StratoPIB::FlushCommandQueue(const char * reason)
+{
+    uint8_t discarded = commandQueue.Flush();
+
+    if (0 != discarded) {
+        snprintf(log_array, LOG_ARRAY_SIZE, "Flushed %u queued commands: %s", discarded, reason);
+        ZephyrLogWarn(log_array);
+    }
+}
+
+void StratoPIB::StartDockDetection(bool power_pu)
+{
+    dock_detect_start = millis();
+    dock_logged = DOCK_UNKNOWN;
+    dockDetector.Configure(pibConfigs.dock_imon_threshold.Read(), pibConfigs.dock_tolerance.Read());
+    dockDetector.SetReelPosition(reelTracker.Valid(), reelTracker.Position());
+
+    // current only flows through the dock contacts with the PU power enabled
+    if (power_pu) digitalWrite(PU_PWR_ENABLE, HIGH);
+    dockDetector.Start(dock_detect_start, power_pu);
+}
+
+DockState_t StratoPIB::DetectDock()
+{
+    DockState_t state = DOCK_UNKNOWN;
+
+    dockDetector.AddCurrent(analogRead(IMON_PU));
+    state = dockDetector.Evaluate();
+
+    if (DOCK_UNKNOWN != state && dock_logged != state) {
+        dock_logged = state;
+        binaryLog.Log(BL_DOCK_DETECTED, (uint8_t) state, (uint16_t) (millis() - dock_detect_start), dockDetector.MeanCurrent());
+    }
+
+    return state;
+}
+
+void StratoPIB::SaveReelPosition()
+{
+    if (!reelTracker.Valid()) return;
+
+    pibConfigs.reel_position.Write(reelTracker.Position());
+    pibConfigs.reel_position_valid.Write(true);
+    binaryLog.Log(BL_REEL_SAVED, reelTracker.Position());
+}
+
+float StratoPIB::DockRevs(float fallback, float limit)
+{
+    float position = reelTracker.Position();
+    float revs = 0.0f;
+
+    // a position outside of the expected range is more likely wrong than the fixed length
+    if (!reelTracker.Valid() || position < 0.0f || position > limit) return fallback;
+
+    revs = position + pibConfigs.dock_overshoot.Read();
+    binaryLog.Log(BL_DOCK_FROM_POSITION, position, revs);
+
+    return revs;
+}
+
+bool StratoPIB::ConfigureDrum()
+{
+    return drumModel.Configure(pibConfigs.drum_core_diameter.Read(), pibConfigs.cable_diameter.Read(),
+                               pibConfigs.drum_width.Read(), pibConfigs.docked_cable_length.Read());
+}
+
+bool StratoPIB::SetProfileMetres(float depth, float dock, float overshoot, float deploy_speed, float retract_speed, float dock_speed)
+{
+    if (!drumModel.Valid()) {
+        ZephyrLogWarn("Drum geometry not configured, can't set profile in metres");
+        return false;
+    }
+
+    if (depth <= dock || dock < 0.0f || overshoot < 0.0f || deploy_speed <= 0.0f || retract_speed <= 0.0f || dock_speed <= 0.0f) {
+        ZephyrLogWarn("Invalid profile in metres");
+        return false;
+    }
+
+    // the profile deploys from the dock to depth, retracts to dock, then docks to the overshoot past the dock
+    pibConfigs.profile_size.Write(drumModel.Revolutions(depth));
+    pibConfigs.dock_amount.Write(drumModel.Revolutions(dock));
+    pibConfigs.dock_overshoot.Write(-drumModel.Revolutions(-overshoot));
+
+    // each move's rpm gives its average speed over the layers it crosses
+    pibConfigs.deploy_velocity.Write(drumModel.AverageRPM(0.0f, depth, deploy_speed));
+    pibConfigs.retract_velocity.Write(drumModel.AverageRPM(depth, dock, retract_speed));
+    pibConfigs.dock_velocity.Write(drumModel.AverageRPM(dock, -overshoot, dock_speed));
+
+    return true;
+}
+
+void StratoPIB::ConfigureRequests()
+{
+    ReliableRequest::SetTimeoutBounds(TARGET_MCB, pibConfigs.mcb_rto_min.Read(), pibConfigs.mcb_rto_max.Read());
+    ReliableRequest::SetTimeoutBounds(TARGET_PU, pibConfigs.pu_rto_min.Read(), pibConfigs.pu_rto_max.Read());
+    ReliableRequest::SetTimeoutBounds(TARGET_ZEPHYR, pibConfigs.zephyr_rto_min.Read(), pibConfigs.zephyr_rto_max.Read());
+
+    ReliableRequest::SetInitialTimeout(TARGET_MCB, MCB_RESEND_TIMEOUT);
+    ReliableRequest::SetInitialTimeout(TARGET_PU, PU_RESEND_TIMEOUT);
+    ReliableRequest::SetInitialTimeout(TARGET_ZEPHYR, ZEPHYR_RESEND_TIMEOUT);
+
+    ReliableRequest::SetRetries(TARGET_MCB, pibConfigs.mcb_retries.Read());
+    ReliableRequest::SetRetries(TARGET_PU, pibConfigs.pu_retries.Read());
+    ReliableRequest::SetRetries(TARGET_ZEPHYR, pibConfigs.zephyr_retries.Read());
+}
+
+void StratoPIB::TraceTransitions()
+{
+    // called at the end of each loop, so the cause is any action consumed by the mode function
+    if (trace_mode != (uint8_t) inst_mode) {
+        transitionTrace.Record(TRACE_SOURCE_MODE, trace_mode, (uint8_t) inst_mode, trace_cause);
+        trace_mode = (uint8_t) inst_mode;
+    }
+
+    if (trace_substate != inst_substate) {
+        transitionTrace.Record(TRACE_SOURCE_SUBSTATE, trace_substate, inst_substate, trace_cause);
+        trace_substate = inst_substate;
+    }
+
+    trace_cause = TRACE_NO_CAUSE;
+}
+
 // --------------------------------------------------------
 // Profile helpers
 // --------------------------------------------------------
 
+float StratoPIB::ExpectedMotionSeconds(MCBMotion_t motion, float revs)
+{
+    float acc = 0.0f;
+
+    switch (motion) {
+    case MOTION_REEL_OUT:
+        return MotionSeconds(revs, pibConfigs.deploy_velocity.Read(), pibConfigs.deploy_acc.Read());
+    case MOTION_REEL_IN:
+        return MotionSeconds(revs, pibConfigs.retract_velocity.Read(), pibConfigs.retract_acc.Read());
+    case MOTION_DOCK:
+        return MotionSeconds(revs, pibConfigs.dock_velocity.Read(), pibConfigs.dock_acc.Read());
+    case MOTION_IN_NO_LW:
+        // dock velocity, but it's unclear which ramp the MCB uses, so assume the slower known one
+        acc = pibConfigs.dock_acc.Read();
+        if (acc <= 0.0f || (pibConfigs.retract_acc.Read() > 0.0f && pibConfigs.retract_acc.Read() < acc)) {
+            acc = pibConfigs.retract_acc.Read();
+        }
+        return MotionSeconds(revs, pibConfigs.dock_velocity.Read(), acc);
+    default:
+        return 0.0f;
+    }
+}
+
 bool StratoPIB::StartMCBMotion()
 {
     bool success = false;
+    PIBLogMessage_t log_id = BL_START_RETRACT;
+    float length = 0.0f;
 
     switch (mcb_motion) {
     case MOTION_REEL_IN:
-        snprintf(log_array, LOG_ARRAY_SIZE, "Retracting %0.1f revs", retract_length);
+        log_id = BL_START_RETRACT;
+        length = retract_length;
         success = mcbComm.TX_Reel_In(retract_length, pibConfigs.retract_velocity.Read());
-        max_profile_seconds = 60 * (retract_length / pibConfigs.retract_velocity.Read()) + pibConfigs.motion_timeout.Read();
+        max_profile_seconds = ExpectedMotionSeconds(mcb_motion, retract_length) + pibConfigs.motion_timeout.Read();
         break;
     case MOTION_REEL_OUT:
         PUUndock();
-        snprintf(log_array, LOG_ARRAY_SIZE, "Deploying %0.1f revs", deploy_length);
+        log_id = BL_START_DEPLOY;
+        length = deploy_length;
         success = mcbComm.TX_Reel_Out(deploy_length, pibConfigs.deploy_velocity.Read());
-        max_profile_seconds = 60 * (deploy_length / pibConfigs.deploy_velocity.Read()) + pibConfigs.motion_timeout.Read();
+        max_profile_seconds = ExpectedMotionSeconds(mcb_motion, deploy_length) + pibConfigs.motion_timeout.Read();
         break;
     case MOTION_DOCK:
-        snprintf(log_array, LOG_ARRAY_SIZE, "Docking %0.1f revs", dock_length);
+        log_id = BL_START_DOCK;
+        length = dock_length;
         success = mcbComm.TX_Dock(dock_length, pibConfigs.dock_velocity.Read());
-        max_profile_seconds = 60 * (dock_length / pibConfigs.dock_velocity.Read()) + pibConfigs.motion_timeout.Read();
+        max_profile_seconds = ExpectedMotionSeconds(mcb_motion, dock_length) + pibConfigs.motion_timeout.Read();
         break;
     case MOTION_IN_NO_LW:
-        snprintf(log_array, LOG_ARRAY_SIZE, "Reel in (no LW) %0.1f revs", retract_length);
+        log_id = BL_START_IN_NO_LW;
+        length = retract_length;
         success = mcbComm.TX_In_No_LW(retract_length, pibConfigs.dock_velocity.Read());
-        max_profile_seconds = 60 * (retract_length / pibConfigs.dock_velocity.Read()) + pibConfigs.motion_timeout.Read();
+        max_profile_seconds = ExpectedMotionSeconds(mcb_motion, retract_length) + pibConfigs.motion_timeout.Read();
         break;
     default:
         mcb_motion = NO_MOTION;
@@ -143,9 +326,30 @@ bool StratoPIB::StartMCBMotion()
         return false;
     }
 
+    // the saved position is invalid until the motion ends
+    if (success) {
+        reelTracker.MotionCommanded((MOTION_REEL_OUT == mcb_motion) ? length : -length);
+        pibConfigs.reel_position_valid.Write(false);
+    }
+
+    // only format the string if it's going to the Zephyr
     if (autonomous_mode) {
-        log_nominal(log_array);
+        binaryLog.Log(log_id, length);
     } else {
+        switch (log_id) {
+        case BL_START_RETRACT:
+            snprintf(log_array, LOG_ARRAY_SIZE, "Retracting %0.1f revs", length);
+            break;
+        case BL_START_DEPLOY:
+            snprintf(log_array, LOG_ARRAY_SIZE, "Deploying %0.1f revs", length);
+            break;
+        case BL_START_DOCK:
+            snprintf(log_array, LOG_ARRAY_SIZE, "Docking %0.1f revs", length);
+            break;
+        default:
+            snprintf(log_array, LOG_ARRAY_SIZE, "Reel in (no LW) %0.1f revs", length);
+            break;
+        }
         ZephyrLogFine(log_array);
     }
 
@@ -154,24 +358,312 @@ bool StratoPIB::StartMCBMotion()
 
 bool StratoPIB::ScheduleProfiles()
 {
+    ProfileDurations_t durations = {0};
+    uint32_t time_now = (uint32_t) now();
+    uint32_t window_end = 0;
+    float latitude = zephyrRX.zephyr_gps.latitude;
+    float longitude = zephyrRX.zephyr_gps.longitude;
+
     // no matter the trigger, reset the time_trigger to the max value, new TC needed to set new value
     pibConfigs.time_trigger.Write(UINT32_MAX);
 
-    // schedule the configured number of profiles starting in five seconds
-    for (int i = 0; i < pibConfigs.num_profiles.Read(); i++) {
-        if (!scheduler.AddAction(ACTION_BEGIN_PROFILE, i * pibConfigs.profile_period.Read() + 5)) {
-            ZephyrLogCrit("Error scheduling profiles, scheduler failure");
-            return false;
-        }
+    // with the SZA trigger, the profiles must finish before the morning crossing
+    if (pibConfigs.sza_trigger.Read() && !(0.0f == latitude && 0.0f == longitude)) {
+        window_end = PredictSZACrossing(time_now, latitude, longitude, pibConfigs.sza_minimum.Read(), false);
     }
 
-    snprintf(log_array, LOG_ARRAY_SIZE, "Scheduled profiles: %u, %0.2f, %0.2f, %0.2f, %u, %u", pibConfigs.num_profiles.Read(),
+    EstimateProfileDurations(&durations);
+    profiles_remaining = profilePlanner.Plan(time_now + PLAN_START_DELAY, window_end, pibConfigs.num_profiles.Read(),
+                                             pibConfigs.profile_period.Read(), durations);
+
+    snprintf(log_array, LOG_ARRAY_SIZE, "Scheduled profiles: %u, %0.2f, %0.2f, %0.2f, %u, %u", profiles_remaining,
              pibConfigs.profile_size.Read(), pibConfigs.dock_amount.Read(), pibConfigs.dock_overshoot.Read(),
              pibConfigs.dwell_time.Read(), pibConfigs.profile_period.Read());
     ZephyrLogFine(log_array);
+
+    if (0 != window_end) {
+        snprintf(log_array, LOG_ARRAY_SIZE, "Packed %u profiles of %lu s before %lu", profiles_remaining, profilePlanner.Duration(), window_end);
+        ZephyrLogFine(log_array);
+    }
+
+    SendPlanTM();
+
+    return ScheduleNextProfile();
+}
+
+bool StratoPIB::ScheduleNextProfile()
+{
+    uint32_t seconds = 0;
+
+    if (!profilePlanner.NextStart((uint32_t) now(), &seconds)) {
+        return true; // nothing left to schedule
+    }
+
+    if (!scheduler.AddAction(ACTION_BEGIN_PROFILE, (0 != seconds) ? seconds : 1)) {
+        ZephyrLogCrit("Error scheduling profiles, scheduler failure");
+        return false;
+    }
+
+    return true;
+}
+
+void StratoPIB::EstimateProfileDurations(ProfileDurations_t * durations)
+{
+    // request latencies from the measured timeouts
+    durations->ra = pibConfigs.parallel_ra.Read() ? 0 : ReliableRequest::Estimate(REQ_RA).rto / 1000;
+    durations->tsen = 2 * ReliableRequest::Estimate(REQ_PU_TSEN).rto / 1000;
+
+    durations->warmup = pibConfigs.puwarmup_time.Read();
+    durations->preprofile = pibConfigs.preprofile_time.Read();
+    durations->dwell = pibConfigs.dwell_time.Read();
+    durations->dock_wait = DOCK_WAIT_TIME;
+
+    // motions from revolutions at rpm, rounded up
+    durations->deploy = (uint32_t) ExpectedMotionSeconds(MOTION_REEL_OUT, pibConfigs.profile_size.Read()) + 1;
+    durations->retract = (uint32_t) ExpectedMotionSeconds(MOTION_REEL_IN, pibConfigs.profile_size.Read() - pibConfigs.dock_amount.Read()) + 1;
+    durations->dock = (uint32_t) ExpectedMotionSeconds(MOTION_DOCK, pibConfigs.dock_amount.Read() + pibConfigs.dock_overshoot.Read()) + 1;
+
+    // the offload depends on the number of records, so use the last one
+    durations->offload = offload_seconds;
+}
+
+void StratoPIB::RePlanProfiles(uint32_t start)
+{
+    ProfileDurations_t durations = {0};
+
+    EstimateProfileDurations(&durations);
+    profiles_remaining = profilePlanner.Plan(start, profilePlanner.WindowEnd(), profiles_remaining,
+                                             profilePlanner.Period(), durations);
+}
+
+bool StratoPIB::ProfileDue()
+{
+    uint32_t seconds = 0;
+
+    // the scheduler has a one second resolution
+    return profilePlanner.NextStart((uint32_t) now(), &seconds) && seconds <= 1;
+}
+
+void StratoPIB::ChargeThresholds(ChargeThresholds_t * thresholds)
+{
+    thresholds->ready_voltage = pibConfigs.pu_ready_voltage.Read();
+    thresholds->min_voltage = pibConfigs.pu_min_voltage.Read();
+    thresholds->full_current = pibConfigs.pu_full_current.Read();
+}
+
+void StratoPIB::PollPUCharge()
+{
+    if (charge_poll_active) {
+        if (Flight_CheckPU(charge_machine, false)) {
+            charge_poll_active = false;
+            if (charge_machine.success) AdvanceForCharge();
+        }
+    } else if ((uint32_t) now() - charge_poll_time >= CHARGE_POLL_PERIOD) {
+        charge_poll_time = (uint32_t) now();
+        Flight_CheckPU(charge_machine, true);
+        charge_poll_active = true;
+    }
+}
+
+void StratoPIB::AdvanceForCharge()
+{
+    ChargeThresholds_t thresholds = {0};
+    uint32_t time_now = (uint32_t) now();
+    uint32_t seconds = 0;
+
+    ChargeThresholds(&thresholds);
+
+    if (!puCharge.Ready(time_now, thresholds) || !profilePlanner.NextStart(time_now, &seconds)) return;
+
+    // not worth re-planning for a small gain
+    if (seconds < PLAN_START_DELAY + CHARGE_ADVANCE_MIN) return;
+
+    RePlanProfiles(time_now + PLAN_START_DELAY);
+    binaryLog.Log(BL_CHARGE_ADVANCE, seconds - PLAN_START_DELAY, puCharge.Voltage(), puCharge.ChargeCurrent());
+    SendPlanTM();
+
+    // the action scheduled for the old start is ignored by ProfileDue
+    if (!ScheduleNextProfile()) {
+        profiles_remaining = 0;
+    }
+}
+
+bool StratoPIB::HoldForCharge()
+{
+    ChargeThresholds_t thresholds = {0};
+    uint32_t time_now = (uint32_t) now();
+    uint32_t seconds = 0;
+
+    if (!pibConfigs.charge_gate.Read()) return false;
+
+    ChargeThresholds(&thresholds);
+
+    // without a recent status there's nothing to base a hold on
+    if (!puCharge.Fresh(time_now)) {
+        ZephyrLogWarn("No recent PU status, starting profile without the charge gate");
+        charge_hold_start = 0;
+        return false;
+    }
+
+    if (puCharge.Ready(time_now, thresholds)) {
+        charge_hold_start = 0;
+        return false;
+    }
+
+    if (0 == charge_hold_start) charge_hold_start = time_now;
+
+    // never start below the minimum voltage, but don't wait forever on a slow charge
+    if (time_now - charge_hold_start >= pibConfigs.charge_max_wait.Read() && puCharge.Voltage() >= thresholds.min_voltage) {
+        snprintf(log_array, LOG_ARRAY_SIZE, "PU not charged after %lu s, starting profile", time_now - charge_hold_start);
+        ZephyrLogWarn(log_array);
+        charge_hold_start = 0;
+        return false;
+    }
+
+    // hold until the predicted ready time, checking again at least every poll period
+    if (!puCharge.SecondsToReady(time_now, thresholds, &seconds) || seconds > CHARGE_POLL_PERIOD) {
+        seconds = CHARGE_POLL_PERIOD;
+    }
+
+    if (seconds < PLAN_START_DELAY) seconds = PLAN_START_DELAY;
+
+    binaryLog.Log(BL_CHARGE_HOLD, seconds, puCharge.Voltage(), puCharge.ChargeCurrent());
+    RePlanProfiles(time_now + seconds);
+
+    if (!ScheduleNextProfile()) {
+        profiles_remaining = 0;
+    }
+
+    return true;
+}
+
+bool StratoPIB::SetPlanEntry(uint8_t index, const ProfileSpec_t & entry)
+{
+    ProfileTable_t table = pibConfigs.profile_table.Read();
+
+    if (index >= PROFILE_TABLE_SIZE || index > table.count) {
+        ZephyrLogWarn("Plan entries must be uploaded in order");
+        return false;
+    }
+
+    if (PLAN_EMPTY == entry.type || entry.type >= NUM_PLAN_TYPES || entry.trigger >= NUM_PLAN_TRIGGERS ||
+        (PLAN_PROFILE == entry.type && (entry.profile_size <= 0.0f || entry.deploy_velocity <= 0.0f || entry.retract_velocity <= 0.0f))) {
+        ZephyrLogWarn("Invalid plan entry");
+        return false;
+    }
+
+    table.entries[index] = entry;
+    if (index == table.count) table.count++;
+
+    pibConfigs.profile_table.Write(table);
+
+    snprintf(log_array, LOG_ARRAY_SIZE, "Set plan entry %u of %u", index + 1, table.count);
+    ZephyrLogFine(log_array);
     return true;
 }
 
+void StratoPIB::ClearProfileTable()
+{
+    ProfileTable_t table = {0};
+
+    pibConfigs.profile_table.Write(table);
+    pibConfigs.plan_index.Write(0);
+}
+
+bool StratoPIB::PlanEntryTriggered()
+{
+    ProfileTable_t table = pibConfigs.profile_table.Read();
+    uint8_t index = pibConfigs.plan_index.Read();
+
+    if (index >= table.count || PLAN_EMPTY == table.entries[index].type) return false;
+
+    switch (table.entries[index].trigger) {
+    case PLAN_TRIGGER_SZA:
+        return zephyrRX.zephyr_gps.solar_zenith_angle > pibConfigs.sza_minimum.Read() || SZATriggerPredicted();
+    case PLAN_TRIGGER_TIME:
+        return (uint32_t) now() >= table.entries[index].trigger_value;
+    case PLAN_TRIGGER_AFTER:
+        return (uint32_t) now() >= plan_last_end + table.entries[index].trigger_value;
+    default:
+        return false;
+    }
+}
+
+void StratoPIB::ApplyPlanEntry(const ProfileSpec_t & entry)
+{
+    uint8_t tsen = (entry.enables & PLAN_ENABLE_TSEN) ? 1 : 0;
+    uint8_t ropc = (entry.enables & PLAN_ENABLE_ROPC) ? 1 : 0;
+    uint8_t flash = (entry.enables & PLAN_ENABLE_FLASH) ? 1 : 0;
+
+    if (PLAN_DOCKED == entry.type) {
+        docked_profile_time = entry.dwell_time;
+        pibConfigs.docked_rate.Write(entry.profile_rate);
+        pibConfigs.docked_TSEN.Write(tsen);
+        pibConfigs.docked_ROPC.Write(ropc);
+        pibConfigs.docked_FLASH.Write(flash);
+        return;
+    }
+
+    pibConfigs.profile_size.Write(entry.profile_size);
+    pibConfigs.deploy_velocity.Write(entry.deploy_velocity);
+    pibConfigs.retract_velocity.Write(entry.retract_velocity);
+    pibConfigs.dwell_time.Write(entry.dwell_time);
+    pibConfigs.profile_rate.Write(entry.profile_rate);
+    pibConfigs.dwell_rate.Write(entry.dwell_rate);
+    pibConfigs.profile_TSEN.Write(tsen);
+    pibConfigs.profile_ROPC.Write(ropc);
+    pibConfigs.profile_FLASH.Write(flash);
+}
+
+void StratoPIB::FinishPlanEntry()
+{
+    uint8_t index = pibConfigs.plan_index.Read() + 1;
+    uint8_t count = pibConfigs.profile_table.Read().count;
+
+    pibConfigs.plan_index.Write(index);
+    plan_last_end = (uint32_t) now();
+
+    snprintf(log_array, LOG_ARRAY_SIZE, "Finished plan entry %u of %u", index, count);
+    ZephyrLogFine(log_array);
+
+    if (index >= count) {
+        ZephyrLogFine("Profile plan complete");
+    }
+}
+
+bool StratoPIB::SZATriggerPredicted()
+{
+    uint32_t lead_time = 0;
+    uint32_t time_now = (uint32_t) now();
+    float latitude = zephyrRX.zephyr_gps.latitude;
+    float longitude = zephyrRX.zephyr_gps.longitude;
+
+    if (!pibConfigs.sza_predict.Read()) return false;
+
+    // no position from the Zephyr yet
+    if (0.0f == latitude && 0.0f == longitude) return false;
+
+    // the balloon drifts slowly, so only re-predict periodically
+    if (0 == sza_predicted || time_now - sza_predicted >= SZA_PREDICT_PERIOD) {
+        sza_crossing = PredictSZACrossing(time_now, latitude, longitude, pibConfigs.sza_minimum.Read(), true);
+        sza_predicted = time_now;
+        binaryLog.Log(BL_SZA_PREDICTION, sza_crossing, SolarZenithAngle(time_now, latitude, longitude));
+    }
+
+    if (0 == sza_crossing) return false;
+
+    // start the profile early enough that the reel out begins at the crossing
+    lead_time = pibConfigs.puwarmup_time.Read() + pibConfigs.preprofile_time.Read() + SZA_PREDICT_MARGIN;
+
+    if (time_now + lead_time >= sza_crossing) {
+        snprintf(log_array, LOG_ARRAY_SIZE, "Predicted SZA crossing in %lu s, starting profiles", sza_crossing - time_now);
+        ZephyrLogFine(log_array);
+        return true;
+    }
+
+    return false;
+}
+
 void StratoPIB::AddMCBTM()
 {
     // make sure it's the correct size
@@ -180,19 +672,37 @@ void StratoPIB::AddMCBTM()
         return;
     }
 
-    // if not in real-time mode, add the sync and time
-    if (!pibConfigs.real_time_mcb.Read()) {
-        // sync byte
-        if (!zephyrTX.addTm((uint8_t) 0xA5)) {
-            log_error("unable to add sync byte to MCB TM buffer");
-            return;
-        }
+    // every raw frame goes to SD, whatever the TM mode sends
+    QueueMCBRecord(MCB_SD_FRAME, mcbComm.binary_rx.bin_buffer, MOTION_TM_SIZE);
 
-        // tenths of seconds since start
-        if (!zephyrTX.addTm((uint16_t) ((millis() - profile_start) / 100))) {
-            log_error("unable to add seconds bytes to MCB TM buffer");
-            return;
-        }
+    if (pibConfigs.real_time_mcb.Read()) {
+        AddRealTimeMCBTM();
+        return;
+    }
+
+    if (pibConfigs.compress_mcb_tm.Read()) {
+        AddCompressedMCBTM();
+        return;
+    }
+
+    static_assert(MCB_TM_HEADER_SIZE + MOTION_RECORD_MAX + MOTION_SUMMARY_SIZE <= MCB_TM_SEGMENT_SIZE,
+                  "an MCB TM segment must hold a frame and the motion summary");
+
+    // seal the segment if the frame and the end-of-motion summary won't both fit
+    if (mcb_tm_bytes + MCB_TM_FRAME_SIZE + MOTION_SUMMARY_SIZE > MCB_TM_SEGMENT_SIZE) {
+        SendMCBTMSegment();
+    }
+
+    // sync byte
+    if (!zephyrTX.addTm((uint8_t) 0xA5)) {
+        log_error("unable to add sync byte to MCB TM buffer");
+        return;
+    }
+
+    // tenths of seconds since start
+    if (!zephyrTX.addTm((uint16_t) ((millis() - profile_start) / 100))) {
+        log_error("unable to add seconds bytes to MCB TM buffer");
+        return;
     }
 
     // add each byte of data to the message
@@ -203,37 +713,328 @@ void StratoPIB::AddMCBTM()
         }
     }
 
-    // if real-time mode, send the TM packet
-    if (pibConfigs.real_time_mcb.Read()) {
-        snprintf(log_array, LOG_ARRAY_SIZE, "MCB TM Packet %u", ++mcb_tm_counter);
-        zephyrTX.setStateDetails(1, log_array);
-        zephyrTX.setStateFlagValue(1, FINE);
-        zephyrTX.setStateFlagValue(2, NOMESS);
-        zephyrTX.setStateFlagValue(3, NOMESS);
-        zephyrTX.TM();
-        log_nominal(log_array);
+    mcb_tm_bytes += MCB_TM_FRAME_SIZE;
+}
+
+void StratoPIB::AddRealTimeMCBTM()
+{
+    uint16_t tenths = (uint16_t) ((millis() - profile_start) / 100);
+    float values[MOTION_DECIMATE_FIELDS] = {0};
+    uint16_t index = MOTION_DECIMATE_INDEX;
+    uint16_t packet_bytes = 0;
+    uint16_t period = pibConfigs.rt_period.Read();
+    bool added = true;
+
+    static_assert(RT_MAX_PACKET <= MCB_TM_SEGMENT_SIZE, "real-time MCB TM packets must fit in the TM buffer");
+
+    // a full raw packet goes early if the budget allows, otherwise frames are dropped until it does
+    if (!pibConfigs.rt_decimate.Read() && mcb_tm_bytes + MCB_TM_FRAME_SIZE > RT_MAX_PACKET && RealTimeBudgetAllows(mcb_tm_bytes)) {
+        SendRealTimeMCBTM();
     }
+
+    if (0 == rt_frames_pending) rt_window_start = millis();
+
+    if (pibConfigs.rt_decimate.Read()) {
+        for (int i = 0; i < MOTION_DECIMATE_FIELDS; i++) {
+            added &= BufferGetFloat(&values[i], mcbComm.binary_rx.bin_buffer, mcbComm.binary_rx.bin_length, &index);
+        }
+        if (added) motionDecimator.Add(tenths, values);
+        packet_bytes = RT_DECIMATE_SIZE;
+    } else if (mcb_tm_bytes + MCB_TM_FRAME_SIZE > RT_MAX_PACKET) {
+        added = false;
+    } else {
+        // the room for the whole frame is checked above, so a failure part-way means the TM
+        // buffer holds bytes not counted in this packet
+        added = zephyrTX.addTm((uint8_t) 0xA5) && zephyrTX.addTm(tenths) &&
+                zephyrTX.addTm(mcbComm.binary_rx.bin_buffer, MOTION_TM_SIZE);
+        if (added) {
+            mcb_tm_bytes += MCB_TM_FRAME_SIZE;
+        } else {
+            // a partial frame can't be removed, so drop the packet rather than send it torn
+            log_error("unable to add frame to real-time MCB TM, packet dropped");
+            zephyrTX.clearTm();
+            mcb_tm_bytes = 0;
+            rt_dropped += rt_frames_pending;
+            rt_frames_pending = 0;
+        }
+        packet_bytes = mcb_tm_bytes;
+    }
+
+    if (!added) {
+        rt_dropped++;
+        return;
+    }
+
+    rt_frames_pending++;
+
+    // send when the window is full, unless the byte budget says to keep aggregating
+    if (rt_frames_pending >= pibConfigs.rt_frames.Read() || (0 != period && millis() - rt_window_start >= 1000 * (uint32_t) period)) {
+        if (RealTimeBudgetAllows(packet_bytes)) {
+            SendRealTimeMCBTM();
+        }
+    }
+}
+
+void StratoPIB::AddDecimatedMCBTM()
+{
+    float fields[3] = {0};
+
+    if (0 == motionDecimator.Count()) return;
+
+    // sync, first and last tenths of seconds, frames, the last status byte, then min/max/mean per field
+    if (!zephyrTX.addTm((uint8_t) RT_DECIMATE_SYNC) || !zephyrTX.addTm(motionDecimator.FirstTenths()) ||
+        !zephyrTX.addTm(motionDecimator.LastTenths()) || !zephyrTX.addTm(motionDecimator.Count()) ||
+        !zephyrTX.addTm(mcbComm.binary_rx.bin_buffer[0])) {
+        log_error("unable to add decimated record to MCB TM buffer");
+        motionDecimator.Reset();
+        return;
+    }
+
+    for (int i = 0; i < MOTION_DECIMATE_FIELDS; i++) {
+        motionDecimator.Summary(i, fields);
+        if (!zephyrTX.addTm((const uint8_t *) fields, sizeof(fields))) { // little-endian floats
+            log_error("unable to add decimated record to MCB TM buffer");
+            break;
+        }
+    }
+
+    mcb_tm_bytes += RT_DECIMATE_SIZE;
+    motionDecimator.Reset();
+}
+
+void StratoPIB::SendRealTimeMCBTM()
+{
+    AddDecimatedMCBTM();
+
+    snprintf(log_array, LOG_ARRAY_SIZE, "MCB TM Packet %u: %u frames, %u dropped", ++mcb_tm_counter, rt_frames_pending, rt_dropped);
+    zephyrTX.setStateDetails(1, log_array);
+    zephyrTX.setStateFlagValue(1, FINE);
+    zephyrTX.setStateFlagValue(2, NOMESS);
+    zephyrTX.setStateFlagValue(3, NOMESS);
+    zephyrTX.TM();
+    binaryLog.Log(BL_MCB_TM_PACKET, mcb_tm_counter);
+
+    zephyrTX.clearTm();
+    mcb_tm_bytes = 0;
+    rt_frames_pending = 0;
+    rt_dropped = 0;
+}
+
+bool StratoPIB::RealTimeBudgetAllows(uint16_t bytes)
+{
+    uint16_t budget = pibConfigs.rt_budget.Read(); // bytes per minute, 0 for unlimited
+    uint16_t period = pibConfigs.rt_period.Read();
+    uint32_t time_now = millis();
+    float capacity = 0.0f;
+
+    if (0 == budget) return true;
+
+    // the bucket holds one packet period of budget (a minute for frames only), and at least one full packet
+    capacity = budget * ((0 != period) ? period : 60) / 60.0f;
+    if (capacity < RT_MAX_PACKET + RT_TM_OVERHEAD) capacity = RT_MAX_PACKET + RT_TM_OVERHEAD;
+
+    // refilled over time across motions, so back-to-back motions share the budget
+    rt_tokens += budget * (time_now - rt_refilled) / 60000.0f;
+    if (rt_tokens > capacity) rt_tokens = capacity;
+    rt_refilled = time_now;
+
+    if (rt_tokens < bytes + RT_TM_OVERHEAD) return false;
+
+    rt_tokens -= bytes + RT_TM_OVERHEAD;
+    return true;
+}
+
+void StratoPIB::AddCompressedMCBTM()
+{
+    uint8_t record[MOTION_RECORD_MAX] = {0};
+    uint8_t record_size = 0;
+
+    static_assert(MOTION_FRAME_SIZE == MOTION_TM_SIZE, "MotionCodec frame size must match the MCB motion TM");
+
+    // seal the segment if the largest record and the end-of-motion summary won't both fit
+    if (mcb_tm_bytes + MOTION_RECORD_MAX + MOTION_SUMMARY_SIZE > MCB_TM_SEGMENT_SIZE) {
+        SendMCBTMSegment();
+    }
+
+    record_size = motionEncoder.Encode(mcbComm.binary_rx.bin_buffer, (uint16_t) ((millis() - profile_start) / 100),
+                                       record, MOTION_RECORD_MAX);
+
+    if (0 == record_size || !zephyrTX.addTm(record, record_size)) {
+        log_error("unable to add compressed frame to MCB TM buffer");
+        motionEncoder.Reset(); // the next frame must be a keyframe for the decoder to recover
+        return;
+    }
+
+    mcb_tm_bytes += record_size;
+}
+
+void StratoPIB::AddMCBTMHeader()
+{
+    // the motion start time, motion id, and segment number head each segment
+    zephyrTX.addTm(mcb_motion_time);
+    zephyrTX.addTm(mcb_motion_id);
+    zephyrTX.addTm(mcb_tm_segment);
+    mcb_tm_bytes = MCB_TM_HEADER_SIZE;
+
+    // each segment decodes on its own
+    motionEncoder.Reset();
+}
+
+void StratoPIB::SendMCBTMSegment()
+{
+    snprintf(log_array, LOG_ARRAY_SIZE, "MCB TM motion %u segment %u", mcb_motion_id, mcb_tm_segment);
+    zephyrTX.setStateDetails(1, log_array);
+    zephyrTX.setStateFlagValue(1, FINE);
+    zephyrTX.setStateFlagValue(2, NOMESS);
+    zephyrTX.setStateFlagValue(3, NOMESS);
+
+    TM_ack_flag = NO_ACK;
+    zephyrTX.TM();
+    binaryLog.Log(BL_MCB_TM_SEGMENT, mcb_motion_id, mcb_tm_segment);
+
+    // start the next segment
+    zephyrTX.clearTm();
+    mcb_tm_segment++;
+    AddMCBTMHeader();
+}
+
+void StratoPIB::AnalyzeMotionTM()
+{
+    float values[NUM_MOTION_STATS] = {0};
+    uint16_t indices[NUM_MOTION_STATS] = {0};
+
+    static_assert(MOTION_TM_FRAME_SIZE == MOTION_TM_SIZE, "MotionTM.h layout must match the MCB motion TM");
+
+    if (mcbComm.binary_rx.bin_length != MOTION_TM_SIZE) return;
+
+    indices[MOTION_STAT_CURRENT] = MOTION_TM_CURRENT_INDEX;
+    indices[MOTION_STAT_TORQUE] = MOTION_TM_TORQUE_INDEX;
+    indices[MOTION_STAT_TEMP] = MOTION_TM_TEMP_INDEX;
+    indices[MOTION_STAT_SPEED] = MOTION_TM_SPEED_INDEX;
+
+    for (int i = 0; i < NUM_MOTION_STATS; i++) {
+        if (!BufferGetFloat(&values[i], mcbComm.binary_rx.bin_buffer, mcbComm.binary_rx.bin_length, &indices[i])) {
+            log_error("unable to read motion stats from MCB TM");
+            return;
+        }
+    }
+
+    motionStats.Add(values);
+    CheckMotionAnomaly(values);
+}
+
+void StratoPIB::ConfigureMotionAnomaly()
+{
+    AnomalyLimits_t limits = {};
+
+    limits.torque_slope = pibConfigs.torque_slope_limit.Read();
+    limits.current_slope = pibConfigs.current_slope_limit.Read();
+    limits.temp_slack = pibConfigs.temp_cusum_slack.Read();
+    limits.temp_cusum = pibConfigs.temp_cusum_limit.Read();
+
+    motionAnomaly.Configure(limits);
+}
+
+void StratoPIB::CheckMotionAnomaly(const float * values)
+{
+    MotionAnomaly_t anomaly = ANOMALY_NONE;
+    const char * names[] = {"none", "torque slope", "current slope", "temperature CUSUM"};
+
+    if (!mcb_motion_ongoing) return;
+
+    anomaly = motionAnomaly.Add(millis(), values[MOTION_STAT_CURRENT], values[MOTION_STAT_TORQUE], values[MOTION_STAT_TEMP]);
+    if (ANOMALY_NONE == anomaly) return;
+
+    // cancel before the MCB faults, and treat it as a motion fault
+    mcbComm.TX_ASCII(MCB_CANCEL_MOTION);
+    CheckAction(ACTION_MOTION_TIMEOUT); // clear the timeout
+    mcb_motion_ongoing = false;
+    mcb_dock_ongoing = false;
+    reelTracker.MotionEnded(false);
+    SaveReelPosition();
+
+    binaryLog.Log(BL_MOTION_ANOMALY, (uint8_t) anomaly, motionAnomaly.Value(), motionAnomaly.Limit());
+    snprintf(log_array, LOG_ARRAY_SIZE, "Motion cancelled on %s: %0.2f > %0.2f", names[anomaly], motionAnomaly.Value(), motionAnomaly.Limit());
+    SendMCBTM(CRIT, log_array);
+    inst_substate = MODE_ERROR;
+}
+
+void StratoPIB::AddMotionSummary()
+{
+    float fields[MOTION_STAT_FIELDS] = {0};
+    uint16_t samples = motionStats.Samples();
+
+    if (0 == samples) return;
+
+    // sync, motion, tenths of seconds since start, samples, then the fields for each channel
+    if (!zephyrTX.addTm((uint8_t) MOTION_SUMMARY_SYNC) || !zephyrTX.addTm((uint8_t) mcb_motion) ||
+        !zephyrTX.addTm((uint16_t) ((millis() - profile_start) / 100)) || !zephyrTX.addTm(samples)) {
+        log_error("unable to add motion summary to MCB TM buffer");
+        motionStats.Reset();
+        return;
+    }
+
+    for (int i = 0; i < NUM_MOTION_STATS; i++) {
+        motionStats.Summary((MotionChannel_t) i, fields);
+        if (!zephyrTX.addTm((const uint8_t *) fields, sizeof(fields))) { // little-endian floats
+            log_error("unable to add motion summary to MCB TM buffer");
+            break;
+        }
+    }
+
+    mcb_tm_bytes += MOTION_SUMMARY_SIZE;
+
+    motionStats.Summary(MOTION_STAT_CURRENT, fields);
+    binaryLog.Log(BL_MOTION_STATS, samples, fields[0], fields[3]);
+
+    // one summary per motion
+    motionStats.Reset();
 }
 
 void StratoPIB::NoteProfileStart()
 {
+    uint8_t start_record[5] = {0};
+
     mcb_motion_ongoing = true;
     profile_start = millis();
 
     if (MOTION_DOCK == mcb_motion || MOTION_IN_NO_LW == mcb_motion) mcb_dock_ongoing = true;
 
     mcb_tm_counter = 0;
+    mcb_tm_bytes = 0;
+    mcb_tm_segment = 0;
+    rt_frames_pending = 0;
+    rt_dropped = 0;
+    motionDecimator.Reset();
+    mcb_motion_id++;
+    mcb_motion_time = now();
+    motionStats.Reset();
+    // docking ends on a torque limit by design
+    motionAnomaly.Reset(MOTION_DOCK != mcb_motion && MOTION_IN_NO_LW != mcb_motion);
 
     zephyrTX.clearTm(); // empty the TM buffer for incoming MCB motion data
 
-    // Add the start time to the MCB TM Header if not in real-time mode
+    start_record[0] = (uint8_t) mcb_motion_time;
+    start_record[1] = (uint8_t) (mcb_motion_time >> 8);
+    start_record[2] = (uint8_t) (mcb_motion_time >> 16);
+    start_record[3] = (uint8_t) (mcb_motion_time >> 24);
+    start_record[4] = (uint8_t) mcb_motion;
+    QueueMCBRecord(MCB_SD_START, start_record, sizeof(start_record));
+
+    // Add the start time, motion id, and segment to the MCB TM Header if not in real-time mode
     if (!pibConfigs.real_time_mcb.Read()) {
-        zephyrTX.addTm((uint32_t) now()); // as a header, add the current seconds since epoch
+        AddMCBTMHeader();
     }
 }
 
 void StratoPIB::SendMCBTM(StateFlag_t state_flag, const char * message)
 {
+    uint8_t report[1 + LOG_ARRAY_SIZE] = {0};
+
+    // the rest of a real-time window goes with the final report
+    if (pibConfigs.real_time_mcb.Read()) AddDecimatedMCBTM();
+    AddMotionSummary();
+
     // use only the first flag to report the motion
     zephyrTX.setStateDetails(1, message);
     zephyrTX.setStateFlagValue(1, state_flag);
@@ -245,8 +1046,23 @@ void StratoPIB::SendMCBTM(StateFlag_t state_flag, const char * message)
 
     log_nominal(log_array);
 
-    if (!WriteFileTM("MCB")) {
-        log_error("Unable to write MCB TM to SD file");
+    report[0] = (uint8_t) state_flag;
+    strncpy((char *) report + 1, message, LOG_ARRAY_SIZE);
+    QueueMCBRecord(MCB_SD_REPORT, report, 1 + strnlen(message, LOG_ARRAY_SIZE));
+}
+
+void StratoPIB::QueueMCBRecord(MCBSDRecord_t type, const uint8_t * payload, uint16_t length)
+{
+    uint16_t tenths = (uint16_t) ((millis() - profile_start) / 100);
+    uint8_t header[4] = {(uint8_t) mcb_motion_id, (uint8_t) (mcb_motion_id >> 8), (uint8_t) tenths, (uint8_t) (tenths >> 8)};
+    const SDWriterStats_t & stats = sdWriter.Stats();
+
+    // never wait on the SD card here, drop the record if the queue is full
+    if (sdWriter.Queue((uint8_t) type, header, sizeof(header), payload, length)) {
+        sd_overflowing = false;
+    } else if (!sd_overflowing) {
+        sd_overflowing = true;
+        binaryLog.Log(BL_SD_OVERFLOW, stats.dropped, stats.dropped_bytes, stats.errors);
     }
 }
 
@@ -297,6 +1113,221 @@ void StratoPIB::SendPIBEEPROM()
     log_nominal("Sent PIB EEPROM as TM");
 }
 
+void StratoPIB::SendBinaryLogTM()
+{
+    uint8_t chunk[256];
+    uint16_t chunk_length = 0;
+    uint16_t dropped = binaryLog.Dropped();
+
+    // header: current time and millis to align record timestamps, then the number of overwritten records
+    zephyrTX.clearTm();
+    zephyrTX.addTm((uint32_t) now());
+    zephyrTX.addTm((uint32_t) millis());
+    zephyrTX.addTm(dropped);
+
+    do {
+        chunk_length = binaryLog.Drain(chunk, sizeof(chunk));
+        if (0 != chunk_length && !zephyrTX.addTm(chunk, chunk_length)) {
+            log_error("Unable to add binary log to TM buffer");
+            break;
+        }
+    } while (0 != chunk_length);
+
+    snprintf(log_array, LOG_ARRAY_SIZE, "PIB Binary Log (%u dropped)", dropped);
+    zephyrTX.setStateDetails(1, log_array);
+    zephyrTX.setStateFlagValue(1, FINE);
+    zephyrTX.setStateFlagValue(2, NOMESS);
+    zephyrTX.setStateFlagValue(3, NOMESS);
+
+    // send as TM
+    TM_ack_flag = NO_ACK;
+    zephyrTX.TM();
+
+    log_nominal("Sent binary log as TM");
+}
+
+void StratoPIB::SendTraceTM()
+{
+    uint8_t entry[TRACE_ENTRY_SIZE];
+    uint16_t num_entries = transitionTrace.Count();
+
+    // header: current time and millis to align entry timestamps, then the number of entries since boot
+    zephyrTX.clearTm();
+    zephyrTX.addTm((uint32_t) now());
+    zephyrTX.addTm((uint32_t) millis());
+    zephyrTX.addTm(transitionTrace.Total());
+
+    // oldest to newest, the trace is kept for later requests
+    for (uint16_t i = 0; i < num_entries; i++) {
+        if (0 == transitionTrace.Read(i, entry) || !zephyrTX.addTm(entry, TRACE_ENTRY_SIZE)) {
+            log_error("Unable to add transition trace to TM buffer");
+            break;
+        }
+    }
+
+    snprintf(log_array, LOG_ARRAY_SIZE, "PIB Transition Trace (%u of %lu)", num_entries, transitionTrace.Total());
+    zephyrTX.setStateDetails(1, log_array);
+    zephyrTX.setStateFlagValue(1, FINE);
+    zephyrTX.setStateFlagValue(2, NOMESS);
+    zephyrTX.setStateFlagValue(3, NOMESS);
+
+    // send as TM
+    TM_ack_flag = NO_ACK;
+    zephyrTX.TM();
+
+    log_nominal("Sent transition trace as TM");
+}
+
+void StratoPIB::SendRequestStatsTM()
+{
+    // housekeeping for Flight_* requests
+    // one record per request type: id, completed, failed, retries, min/max/mean RTT (ms),
+    // then the current estimate: SRTT, RTTVAR, RTO (ms), samples
+    zephyrTX.clearTm();
+
+    for (uint8_t i = REQ_NONE + 1; i < NUM_REQUEST_IDS; i++) {
+        const RequestStats_t & stats = ReliableRequest::Stats((RequestID_t) i);
+        const RTTEstimate_t & estimate = ReliableRequest::Estimate((RequestID_t) i);
+
+        zephyrTX.addTm(i);
+        zephyrTX.addTm(stats.completed);
+        zephyrTX.addTm(stats.failed);
+        zephyrTX.addTm(stats.retries);
+        zephyrTX.addTm(stats.rtt_min);
+        zephyrTX.addTm(stats.rtt_max);
+        zephyrTX.addTm((uint32_t) ((0 != stats.completed) ? stats.rtt_total / stats.completed : 0));
+        zephyrTX.addTm(estimate.srtt);
+        zephyrTX.addTm(estimate.rttvar);
+        zephyrTX.addTm(estimate.rto);
+        zephyrTX.addTm(estimate.samples);
+    }
+
+    zephyrTX.setStateDetails(1, "PIB Request Stats");
+    zephyrTX.setStateFlagValue(1, FINE);
+    zephyrTX.setStateFlagValue(2, NOMESS);
+    zephyrTX.setStateFlagValue(3, NOMESS);
+
+    // send as TM
+    TM_ack_flag = NO_ACK;
+    zephyrTX.TM();
+
+    log_nominal("Sent request stats as TM");
+}
+
+void StratoPIB::SendPlanTM()
+{
+    // header: current time, end of the dark window (0 if none), modeled profile length and period, number remaining
+    zephyrTX.clearTm();
+    zephyrTX.addTm((uint32_t) now());
+    zephyrTX.addTm(profilePlanner.WindowEnd());
+    zephyrTX.addTm(profilePlanner.Duration());
+    zephyrTX.addTm(profilePlanner.Period());
+    zephyrTX.addTm(profilePlanner.Remaining());
+
+    // then the planned start time of each remaining profile
+    for (uint8_t i = profilePlanner.Count() - profilePlanner.Remaining(); i < profilePlanner.Count(); i++) {
+        zephyrTX.addTm(profilePlanner.Start(i));
+    }
+
+    // more would fit in the window than the planner holds, the rest of the night is left unplanned
+    if (profilePlanner.Truncated()) {
+        snprintf(log_array, LOG_ARRAY_SIZE, "PIB Profile Plan: %u profiles, %lu s each, truncated at %u", profilePlanner.Remaining(),
+                 profilePlanner.Duration(), PLAN_MAX_PROFILES);
+        zephyrTX.setStateDetails(1, log_array);
+        zephyrTX.setStateFlagValue(1, WARN);
+    } else {
+        snprintf(log_array, LOG_ARRAY_SIZE, "PIB Profile Plan: %u profiles, %lu s each", profilePlanner.Remaining(), profilePlanner.Duration());
+        zephyrTX.setStateDetails(1, log_array);
+        zephyrTX.setStateFlagValue(1, FINE);
+    }
+    zephyrTX.setStateFlagValue(2, NOMESS);
+    zephyrTX.setStateFlagValue(3, NOMESS);
+
+    // send as TM
+    TM_ack_flag = NO_ACK;
+    zephyrTX.TM();
+
+    log_nominal("Sent profile plan as TM");
+}
+
+void StratoPIB::SendCommandQueueTM()
+{
+    const QueuedCommand_t * command = nullptr;
+
+    // header: depth, then the dropped, flushed, and executed counts since boot
+    zephyrTX.clearTm();
+    zephyrTX.addTm(commandQueue.Depth());
+    zephyrTX.addTm(commandQueue.Dropped());
+    zephyrTX.addTm(commandQueue.Flushed());
+    zephyrTX.addTm(commandQueue.Executed());
+
+    // then each queued command, oldest first: type, lengths, profile parameters, seconds,
+    // and the archive night, profile, and packet range (for a retransmit)
+    for (uint8_t i = 0; i < commandQueue.Depth(); i++) {
+        command = commandQueue.Peek(i);
+        float values[6] = {command->deploy_length, command->retract_length, command->dock_length,
+                           command->profile_size, command->dock_amount, command->dock_overshoot};
+
+        zephyrTX.addTm((uint8_t) command->type);
+        zephyrTX.addTm((const uint8_t *) values, sizeof(values)); // little-endian floats
+        zephyrTX.addTm(command->seconds);
+        zephyrTX.addTm(command->night);
+        zephyrTX.addTm(command->profile);
+        zephyrTX.addTm(command->first_packet);
+        zephyrTX.addTm(command->last_packet);
+    }
+
+    snprintf(log_array, LOG_ARRAY_SIZE, "PIB Command Queue: %u queued, %u dropped", commandQueue.Depth(), commandQueue.Dropped());
+    zephyrTX.setStateDetails(1, log_array);
+    zephyrTX.setStateFlagValue(1, FINE);
+    zephyrTX.setStateFlagValue(2, NOMESS);
+    zephyrTX.setStateFlagValue(3, NOMESS);
+
+    // send as TM
+    TM_ack_flag = NO_ACK;
+    zephyrTX.TM();
+
+    log_nominal("Sent command queue as TM");
+}
+
+void StratoPIB::SendProfileTableTM()
+{
+    ProfileTable_t table = pibConfigs.profile_table.Read();
+
+    // header: plan mode, next entry, number of entries
+    zephyrTX.clearTm();
+    zephyrTX.addTm((uint8_t) pibConfigs.plan_mode.Read());
+    zephyrTX.addTm(pibConfigs.plan_index.Read());
+    zephyrTX.addTm(table.count);
+
+    // then each entry: type, trigger, enables, trigger value, size and velocities (floats), dwell, rates
+    for (uint8_t i = 0; i < table.count && i < PROFILE_TABLE_SIZE; i++) {
+        const ProfileSpec_t & entry = table.entries[i];
+        float values[3] = {entry.profile_size, entry.deploy_velocity, entry.retract_velocity};
+
+        zephyrTX.addTm(entry.type);
+        zephyrTX.addTm(entry.trigger);
+        zephyrTX.addTm(entry.enables);
+        zephyrTX.addTm(entry.trigger_value);
+        zephyrTX.addTm((const uint8_t *) values, sizeof(values)); // little-endian floats
+        zephyrTX.addTm(entry.dwell_time);
+        zephyrTX.addTm(entry.profile_rate);
+        zephyrTX.addTm(entry.dwell_rate);
+    }
+
+    snprintf(log_array, LOG_ARRAY_SIZE, "PIB Profile Table: entry %u of %u", pibConfigs.plan_index.Read(), table.count);
+    zephyrTX.setStateDetails(1, log_array);
+    zephyrTX.setStateFlagValue(1, FINE);
+    zephyrTX.setStateFlagValue(2, NOMESS);
+    zephyrTX.setStateFlagValue(3, NOMESS);
+
+    // send as TM
+    TM_ack_flag = NO_ACK;
+    zephyrTX.TM();
+
+    log_nominal("Sent profile table as TM");
+}
+
 void StratoPIB::SendTSENTM()
 {
     if (0 < snprintf(log_array, LOG_ARRAY_SIZE, "PU TSEN: %lu, %0.2f, %0.2f, %0.2f, %0.2f, %u", pu_status.time, pu_status.v_battery, pu_status.i_charge, pu_status.therm1, pu_status.therm2, pu_status.heater_stat)) {
@@ -337,6 +1368,56 @@ void StratoPIB::SendProfileTM(uint8_t packet_num)
     log_nominal(log_array);
 }
 
+uint16_t StratoPIB::ArchiveNight()
+{
+    // days since epoch in local solar time, less half a day so that a night keeps one number
+    int32_t local = (int32_t) now() + (int32_t) (zephyrRX.zephyr_gps.longitude * 240.0f) - 43200;
+
+    return (uint16_t) (local / 86400);
+}
+
+void StratoPIB::RollArchiveNight()
+{
+    uint16_t night = ArchiveNight();
+
+    if (night != pibConfigs.archive_night.Read()) {
+        pibConfigs.archive_night.Write(night);
+        pibConfigs.archive_profile.Write(0);
+        pibConfigs.archive_tsen.Write(0);
+    }
+}
+
+void StratoPIB::NoteArchiveProfile()
+{
+    RollArchiveNight();
+    pibConfigs.archive_profile.Write(pibConfigs.archive_profile.Read() + 1);
+}
+
+void StratoPIB::ArchivePURecord(uint8_t profile, uint16_t packet)
+{
+    uint16_t night = pibConfigs.archive_night.Read();
+
+    // queued here and written to SD from the loop
+    if (puArchive.Append(night, profile, packet, puComm.binary_rx.bin_buffer, puComm.binary_rx.bin_length)) {
+        binaryLog.Log(BL_PU_ARCHIVED, night, profile, packet, puComm.binary_rx.bin_length);
+    } else {
+        snprintf(log_array, LOG_ARRAY_SIZE, "PU archive queue full, record not archived (%lu dropped)", puArchive.Dropped());
+        log_error(log_array);
+    }
+}
+
+void StratoPIB::StartRetransmit(uint16_t night, uint8_t profile, uint16_t first_packet, uint16_t last_packet)
+{
+    snprintf(log_array, LOG_ARRAY_SIZE, "Retransmitting archived records: night %u, profile %u, packets %u-%u", night, profile, first_packet, last_packet);
+    log_nominal(log_array);
+
+    retransmit_machine.night = night;
+    retransmit_machine.profile = profile;
+    retransmit_machine.first_packet = first_packet;
+    retransmit_machine.count = last_packet - first_packet + 1;
+    if (retransmit_machine.count > PU_ARCHIVE_RANGE) retransmit_machine.count = PU_ARCHIVE_RANGE;
+}
+
 // every 10 minutes, aligned with the hour (called in InstrumentLoop)
 void StratoPIB::CheckTSEN()
 {
@@ -359,12 +1440,13 @@ void StratoPIB::PUUndock()
 {
     pibConfigs.pu_docked.Write(false);
     digitalWrite(PU_PWR_ENABLE, LOW);
+    puCharge.Reset(); // only charges on the dock
 }
 
 void StratoPIB::PUStartProfile()
 {
-    int32_t t_down = 60 * (deploy_length / pibConfigs.deploy_velocity.Read()) + pibConfigs.preprofile_time.Read();
-    int32_t t_up = 60 * (retract_length / pibConfigs.retract_velocity.Read() + dock_length / pibConfigs.dock_velocity.Read())
+    int32_t t_down = ExpectedMotionSeconds(MOTION_REEL_OUT, deploy_length) + pibConfigs.preprofile_time.Read();
+    int32_t t_up = ExpectedMotionSeconds(MOTION_REEL_IN, retract_length) + ExpectedMotionSeconds(MOTION_DOCK, dock_length)
                    + pibConfigs.motion_timeout.Read(); // extra time for dock delay
 
     puComm.TX_Profile(t_down, pibConfigs.dwell_time.Read(), t_up, pibConfigs.profile_rate.Read(), pibConfigs.dwell_rate.Read(),
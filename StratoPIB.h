@@ -15,6 +15,26 @@
 #include "PIBHardware.h"
 #include "PIBBufferGuard.h"
 #include "PIBConfigs.h"
+#include "BinaryLog.h"
+#include "TransitionTrace.h"
+#include "SolarPosition.h"
+#include "MotionModel.h"
+#include "DrumModel.h"
+#include "ReelTracker.h"
+#include "DockDetector.h"
+#include "MotionTM.h"
+#include "MotionStats.h"
+#include "MotionAnomaly.h"
+#include "MotionCodec.h"
+#include "MotionDecimator.h"
+#include "ProfilePlanner.h"
+#include "PUCharge.h"
+#include "PUCompress.h"
+#include "PUArchive.h"
+#include "SDWriter.h"
+#include "CommandQueue.h"
+#include "PIBLogging.h"
+#include "FlightMachines.h"
 #include "MCBComm.h"
 #include "PUComm.h"
 
@@ -23,12 +43,69 @@
 // number of loops before a flag becomes stale and is reset
 #define FLAG_STALE      3
 
+// seconds to wait after the reel in before docking (unless the motion timeout comes first)
+#define DOCK_WAIT_TIME  60
+
+// seconds for fast dock detection before falling back to a PU status request
+#define DOCK_DETECT_TIMEOUT 2
+
+// ms between zeroing the reel and commanding the MCB to low power
+#define MCB_ZERO_REEL_GAP   100
+
+// seconds assumed for a PU offload until one has been timed
+#define OFFLOAD_ESTIMATE    600
+
+// seconds between PU status polls while a profile waits on the charge gate,
+// and the least a profile is moved up once the PU is charged
+#define CHARGE_POLL_PERIOD  120
+#define CHARGE_ADVANCE_MIN  300
+
+// seconds between SZA crossing predictions, and extra lead before the crossing
+#define SZA_PREDICT_PERIOD  300
+#define SZA_PREDICT_MARGIN  60
+
+// resend timeouts, and the initial RTO for Flight_* requests until RTTs are measured
 #define MCB_RESEND_TIMEOUT      10
 #define PU_RESEND_TIMEOUT       10
 #define ZEPHYR_RESEND_TIMEOUT   60
 
 #define RETRY_DOCK_LENGTH   2.0f
 
+// revs to dock after a safety full retract if the reel position isn't known
+#define SAFETY_DOCK_LENGTH  200.0f
+
+// sync byte for the motion summary record (motion TM frames use 0xA5)
+#define MOTION_SUMMARY_SYNC 0xA6
+#define MOTION_SUMMARY_SIZE (6 + 4 * NUM_MOTION_STATS * MOTION_STAT_FIELDS)
+
+// bytes in a segment of buffered MCB motion TM before it's sealed and sent, kept below
+// the Zephyr TM buffer (MAX_TM_BUFFER in StratoCore's XMLWriter.h) with some headroom
+#ifndef MAX_TM_BUFFER
+#error "MCB TM segments are sized from XMLWriter's MAX_TM_BUFFER"
+#endif
+#define MCB_TM_HEADROOM     192
+#define MCB_TM_SEGMENT_SIZE (MAX_TM_BUFFER - MCB_TM_HEADROOM)
+#define MCB_TM_HEADER_SIZE  7                       // start time, motion id, segment
+#define MCB_TM_FRAME_SIZE   (3 + MOTION_TM_SIZE)    // sync, tenths of seconds, frame
+
+// real-time MCB TM: decimated record (sync 0xA9, first and last tenths, frames, status,
+// min/max/mean floats), the most raw frames per packet, and the approximate Zephyr
+// framing per TM counted against the byte budget
+#define RT_DECIMATE_SYNC    0xA9
+#define RT_DECIMATE_SIZE    (8 + 12 * MOTION_DECIMATE_FIELDS)
+#define RT_MAX_PACKET       2000
+#define RT_TM_OVERHEAD      100
+
+// MCB motion records queued for the SD card (see SDWriter.h), replacing the MCB TM file,
+// each starting with the motion id and tenths of seconds since the motion start (u16s)
+#define MCB_SD_FILE         "MCBTM.DAT"
+
+enum MCBSDRecord_t : uint8_t {
+    MCB_SD_START,   // then start time (u32), motion type
+    MCB_SD_FRAME,   // then the raw frame
+    MCB_SD_REPORT   // then the state flag, report text
+};
+
 #define MCB_BUFFER_SIZE     MAX_MCB_BINARY
 #define PU_BUFFER_SIZE      8192
 
@@ -40,41 +117,22 @@ enum ScheduleAction_t : uint8_t {
     SEND_IMR,
     RESEND_SAFETY,
     RESEND_MCB_LP,
-    RESEND_RA,
     RESEND_MOTION_COMMAND,
-    RESEND_TM,
-    RESEND_PU_CHECK,
-    RESEND_PU_TSEN,
-    RESEND_PU_RECORD,
-    RESEND_PU_WARMUP,
-    RESEND_PU_GOPROFILE,
     RESEND_FULL_RETRACT,
 
     // exit the error state (ground command only)
     EXIT_ERROR_STATE,
 
     // internal actions
-    ACTION_REEL_OUT,
-    ACTION_REEL_IN,
-    ACTION_IN_NO_LW,
-    ACTION_DOCK,
     ACTION_MOTION_STOP,
     ACTION_BEGIN_PROFILE,
-    ACTION_END_DWELL,
     ACTION_CHECK_PU,
     ACTION_REQUEST_TSEN, // send the TSEN request
-    ACTION_END_WARMUP,
-    ACTION_END_PREPROFILE,
     ACTION_OVERRIDE_TSEN, // if TSEN in manual, override for command
-    ACTION_OFFLOAD_PU,
     ACTION_MOTION_TIMEOUT,
-    ACTION_END_DOCK_WAIT,
 
     // Multi-action commands
-    COMMAND_REDOCK,    // reel out, reel in (no lw), check PU
     COMMAND_SEND_TSEN, // check PU, request TSEN, send TM
-    COMMAND_MANUAL_PROFILE,
-    COMMAND_DOCKED_PROFILE,
 
     // used for tracking
     NUM_ACTIONS
@@ -121,6 +179,15 @@ private:
     // EEPROM interface object
     PIBConfigs pibConfigs;
 
+    // binary log records, formatted on the ground
+    BinaryLog binaryLog;
+
+    // timestamped mode, substate, and Flight_* transitions
+    TransitionTrace transitionTrace;
+    uint8_t trace_mode = TRACE_NO_CAUSE;     // last recorded inst_mode
+    uint8_t trace_substate = TRACE_NO_CAUSE; // last recorded inst_substate
+    uint8_t trace_cause = TRACE_NO_CAUSE;    // last action flag consumed this loop
+
     // Mode functions (implemented in unique source files)
     void StandbyMode();
     void FlightMode();
@@ -135,13 +202,42 @@ private:
     // Flight states under autonomous or manual (each in own .cpp file)
     // when starting the state, call with restart_state = true
     // then call with restart_state = false until the function returns true meaning it's completed
-    bool Flight_CheckPU(bool restart_state);
-    bool Flight_Profile(bool restart_state);
-    bool Flight_ReDock(bool restart_state);
-    bool Flight_PUOffload(bool restart_state);
-    bool Flight_TSEN(bool restart_state);
-    bool Flight_ManualMotion(bool restart_state);
-    bool Flight_DockedProfile(bool restart_state);
+    // each operates on a machine instance owned by the caller (see FlightMachines.h)
+    bool Flight_CheckPU(CheckPUMachine_t & machine, bool restart_state);
+    bool Flight_Profile(ProfileMachine_t & machine, bool restart_state);
+    bool Flight_ReDock(ReDockMachine_t & machine, bool restart_state);
+    bool Flight_PUOffload(PUOffloadMachine_t & machine, bool restart_state);
+    bool Flight_TSEN(TSENMachine_t & machine, bool restart_state);
+    bool Flight_ManualMotion(ManualMotionMachine_t & machine, bool restart_state);
+    bool Flight_RA(RAMachine_t & machine, bool restart_state);
+    bool Flight_DockedProfile(DockedProfileMachine_t & machine, bool restart_state);
+    bool Flight_Retransmit(RetransmitMachine_t & machine, bool restart_state);
+
+    // top-level Flight_* instances, shared by manual and autonomous flight
+    ProfileMachine_t profile_machine;
+    TSENMachine_t tsen_machine;
+    PUOffloadMachine_t offload_machine;
+    ReDockMachine_t redock_machine;
+    DockedProfileMachine_t docked_machine;
+    ManualMotionMachine_t manual_motion_machine;
+    RetransmitMachine_t retransmit_machine;
+
+    // PU status polls that run alongside other sequences, each with its own instance
+    // that is restarted whenever the poll starts (see FL_ENTRY and FLA_IDLE)
+    CheckPUMachine_t status_machine; // manual GETPUSTATUS
+    bool status_poll_active = false;
+    CheckPUMachine_t charge_machine; // autonomous charge model updates
+    bool charge_poll_active = false;
+
+    // manual motion and sequence TCs, run in order from FLM_IDLE
+    CommandQueue commandQueue;
+
+    // Queue a manual command (and override TSEN to start it), or flush the queue
+    void QueueCommand(const QueuedCommand_t & command);
+    void FlushCommandQueue(const char * reason);
+
+    // Start the Flight_* sequence for a dequeued command, returns the manual substate
+    uint8_t StartQueuedCommand(const QueuedCommand_t & command);
 
     // Telcommand handler - returns ack/nak
     void TCHandler(Telecommand_t telecommand);
@@ -158,6 +254,9 @@ private:
     // Monitor the action flags and clear old ones
     void WatchFlags();
 
+    // Record mode and substate changes in the transition trace
+    void TraceTransitions();
+
     // Handle messages from the MCB (in MCBRouter.cpp)
     void HandleMCBASCII();
     void HandleMCBAck();
@@ -172,15 +271,119 @@ private:
     void HandlePUString();
     uint8_t binary_pu[PU_BUFFER_SIZE];
 
+    // Add a PU profile record to the TM buffer, compressed if enabled (see PUCompress.h)
+    bool AddPURecordTM(const uint8_t * record, uint16_t record_length);
+    PURecordCompressor puCompressor;
+    uint8_t pu_compressed[PU_COMPRESS_BOUND(PU_BUFFER_SIZE)];
+
     // Start any type of MCB motion
     bool StartMCBMotion();
 
-    // Schedule profiles in autonomous mode
+    // Expected seconds for a motion of revs from the configured velocity and acceleration
+    float ExpectedMotionSeconds(MCBMotion_t motion, float revs);
+
+    // reel position and velocity from the MCB motion TM and commanded motions
+    ReelTracker reelTracker;
+    void SaveReelPosition();
+
+    // Revs to dock from the tracked position (plus overshoot), or fallback if it's unknown or beyond limit
+    float DockRevs(float fallback, float limit);
+
+    // fast dock detection from PU UART traffic, IMON_PU, and the reel position
+    DockDetector dockDetector;
+    void StartDockDetection(bool power_pu);
+    DockState_t DetectDock();
+    uint32_t dock_detect_start = 0; // ms
+    DockState_t dock_logged = DOCK_UNKNOWN; // last decision logged this run
+
+    // revolutions <-> metres of cable, configured from EEPROM
+    DrumModel drumModel;
+    bool ConfigureDrum();
+
+    // Convert a profile in metres and m/s to the revolution and rpm configs
+    bool SetProfileMetres(float depth, float dock, float overshoot, float deploy_speed, float retract_speed, float dock_speed);
+
+    // Plan the night's profiles in autonomous mode and schedule the first (sends the plan as TM)
     bool ScheduleProfiles();
 
+    // After a profile, re-plan if it ran long and schedule the next
+    bool ScheduleNextProfile();
+
+    // Model each profile step from the configurations and measurements
+    void EstimateProfileDurations(ProfileDurations_t * durations);
+
+    // Re-plan the remaining profiles from start with the current duration model
+    void RePlanProfiles(uint32_t start);
+
+    // True if the next planned profile is due (scheduled actions from before a re-plan are ignored)
+    bool ProfileDue();
+
+    // Charge gate: poll the PU while it charges, move the next profile up once it's ready,
+    // and hold a due profile (true if held) until it's predicted ready
+    void PollPUCharge();
+    void AdvanceForCharge();
+    bool HoldForCharge();
+    void ChargeThresholds(ChargeThresholds_t * thresholds);
+
+    // Profile plan table: check the next entry's trigger, start it (returns the autonomous substate),
+    // write its parameters to the configs, and note its end
+    bool PlanEntryTriggered();
+    uint8_t StartPlanEntry();
+    void ApplyPlanEntry(const ProfileSpec_t & entry);
+    void FinishPlanEntry();
+
+    // Profile plan table uploads (entries must be set in order)
+    bool SetPlanEntry(uint8_t index, const ProfileSpec_t & entry);
+    void ClearProfileTable();
+    uint32_t plan_last_end = 0; // seconds since epoch
+
+    ProfilePlanner profilePlanner;
+    uint32_t profile_start_time = 0;  // seconds since epoch
+    uint32_t offload_start_time = 0;  // seconds since epoch
+    uint32_t offload_seconds = OFFLOAD_ESTIMATE;
+
+    PUChargeModel puCharge;
+    uint32_t charge_poll_time = 0;  // seconds since epoch
+    uint32_t charge_hold_start = 0; // seconds since epoch (0 if not holding)
+
+    // True if the predicted SZA crossing is within the profile warmup lead time
+    bool SZATriggerPredicted();
+    uint32_t sza_crossing = 0;   // predicted time of the next sza_minimum crossing (0 if none)
+    uint32_t sza_predicted = 0;  // time of the last prediction
+
     // Add an MCB motion TM packet to the binary TM buffer
     void AddMCBTM();
 
+    // MCB motion records go to SD through the RAM queue, drained in InstrumentLoop
+    SDWriter sdWriter;
+    void QueueMCBRecord(MCBSDRecord_t type, const uint8_t * payload, uint16_t length);
+    bool sd_overflowing = false;
+
+    // Buffered MCB TM is split into segments sharing a motion id
+    void AddMCBTMHeader();
+    void SendMCBTMSegment();
+
+    // Real-time MCB TM aggregated over rt_frames or rt_period, within rt_budget
+    MotionDecimator motionDecimator;
+    void AddRealTimeMCBTM();
+    void AddDecimatedMCBTM();
+    void SendRealTimeMCBTM();
+    bool RealTimeBudgetAllows(uint16_t bytes);
+
+    // Buffered MCB TM frames as a keyframe and deltas per segment (see MotionCodec.h)
+    MotionEncoder motionEncoder;
+    void AddCompressedMCBTM();
+
+    // streaming stats over the current motion, summarized in the TM at the end of each motion
+    MotionStats motionStats;
+    void AnalyzeMotionTM();
+    void AddMotionSummary();
+
+    // cancels the motion on a rising torque, current, or temperature trend
+    MotionAnomaly motionAnomaly;
+    void ConfigureMotionAnomaly();
+    void CheckMotionAnomaly(const float * values);
+
     // Set variables and TM buffer after a profile starts
     void NoteProfileStart();
 
@@ -191,10 +394,29 @@ private:
     void SendMCBEEPROM();
     void SendPIBEEPROM();
 
+    // Send a telemetry packet with the binary log contents
+    void SendBinaryLogTM();
+    void SendTraceTM();
+    void SendRequestStatsTM();
+    void SendPlanTM();
+    void SendCommandQueueTM();
+    void SendProfileTableTM();
+
+    // Apply the request timeouts and retry counts from the constants and EEPROM
+    void ConfigureRequests();
+
     // send a telemetry packet with PU TSEN or Profile Record info
     void SendTSENTM();
     void SendProfileTM(uint8_t packet_num);
 
+    // every received PU record is archived to SD, keyed by night, profile, and packet
+    PUArchive puArchive;
+    uint16_t ArchiveNight();
+    void RollArchiveNight();
+    void NoteArchiveProfile();
+    void ArchivePURecord(uint8_t profile, uint16_t packet);
+    void StartRetransmit(uint16_t night, uint8_t profile, uint16_t first_packet, uint16_t last_packet);
+
     // sets an action flag every ten minutes aligned with the hour
     void CheckTSEN();
 
@@ -217,6 +439,15 @@ private:
     uint32_t max_profile_seconds = 0;
     bool mcb_reeling_in = false;
     uint16_t mcb_tm_counter = 0;
+    uint16_t mcb_tm_bytes = 0;     // in the current segment
+    uint16_t mcb_motion_id = 0;    // incremented with each motion
+    uint8_t mcb_tm_segment = 0;
+    uint32_t mcb_motion_time = 0;  // seconds since epoch at the motion start
+    uint16_t rt_frames_pending = 0; // in the current real-time packet
+    uint16_t rt_dropped = 0;        // raw frames that didn't fit in the packet
+    uint32_t rt_window_start = 0;   // ms
+    uint32_t rt_refilled = 0;       // ms
+    float rt_tokens = 0.0f;         // bytes available under the budget
 
     // flags for PU state tracking
     bool record_received = false;
@@ -225,7 +456,7 @@ private:
     bool pu_warmup = false;
     bool pu_profile = false;
     bool pu_preprofile = false;
-    bool check_pu_success = false;
+    bool pu_reset = false;
 
     // tracks the number of profiles remaining in autonomous mode and if they're scheduled
     uint8_t profiles_remaining = 0;
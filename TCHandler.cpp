@@ -12,7 +12,10 @@
 void StratoPIB::TCHandler(Telecommand_t telecommand)
 {
     String dbg_msg = "";
-    log_debug("Received telecommand");
+    QueuedCommand_t command = {QCMD_NONE};
+    ProfileSpec_t plan_entry = {PLAN_EMPTY};
+    PIB_LOG_DEBUG("Received telecommand");
+    transitionTrace.Record(TRACE_SOURCE_TELECOMMAND, inst_substate, (uint8_t) telecommand, TRACE_NO_CAUSE);
 
     switch (telecommand) {
 
@@ -22,9 +25,9 @@ void StratoPIB::TCHandler(Telecommand_t telecommand)
             ZephyrLogWarn("Switch to manual mode before commanding motion");
             break;
         }
-        deploy_length = mcbParam.deployLen;
-        SetAction(ACTION_REEL_OUT); // will be ignored if wrong mode
-        SetAction(ACTION_OVERRIDE_TSEN);
+        command.type = QCMD_REEL_OUT;
+        command.deploy_length = mcbParam.deployLen;
+        QueueCommand(command);
         break;
     case DEPLOYv:
         pibConfigs.deploy_velocity.Write(mcbParam.deployVel);
@@ -34,6 +37,8 @@ void StratoPIB::TCHandler(Telecommand_t telecommand)
     case DEPLOYa:
         if (!mcbComm.TX_Out_Acc(mcbParam.deployAcc)) {
             ZephyrLogWarn("Error sending deploy acc to MCB");
+        } else {
+            pibConfigs.deploy_acc.Write(mcbParam.deployAcc); // for the motion time model
         }
         break;
     case RETRACTx:
@@ -41,9 +46,9 @@ void StratoPIB::TCHandler(Telecommand_t telecommand)
             ZephyrLogWarn("Switch to manual mode before commanding motion");
             break;
         }
-        retract_length = mcbParam.retractLen;
-        SetAction(ACTION_REEL_IN); // will be ignored if wrong mode
-        SetAction(ACTION_OVERRIDE_TSEN);
+        command.type = QCMD_REEL_IN;
+        command.retract_length = mcbParam.retractLen;
+        QueueCommand(command);
         break;
     case RETRACTv:
         pibConfigs.retract_velocity.Write(mcbParam.retractVel);
@@ -53,6 +58,8 @@ void StratoPIB::TCHandler(Telecommand_t telecommand)
     case RETRACTa:
         if (!mcbComm.TX_In_Acc(mcbParam.retractAcc)) {
             ZephyrLogWarn("Error sending retract acc to MCB");
+        } else {
+            pibConfigs.retract_acc.Write(mcbParam.retractAcc); // for the motion time model
         }
         break;
     case DOCKx:
@@ -60,9 +67,9 @@ void StratoPIB::TCHandler(Telecommand_t telecommand)
             ZephyrLogWarn("Switch to manual mode before commanding motion");
             break;
         }
-        dock_length = mcbParam.dockLen;
-        SetAction(ACTION_DOCK); // will be ignored if wrong mode
-        SetAction(ACTION_OVERRIDE_TSEN);
+        command.type = QCMD_DOCK;
+        command.dock_length = mcbParam.dockLen;
+        QueueCommand(command);
         break;
     case DOCKv:
         pibConfigs.dock_velocity.Write(mcbParam.dockVel);
@@ -72,6 +79,8 @@ void StratoPIB::TCHandler(Telecommand_t telecommand)
     case DOCKa:
         if (!mcbComm.TX_Dock_Acc(mcbParam.dockAcc)) {
             ZephyrLogWarn("Error sending dock acc to MCB");
+        } else {
+            pibConfigs.dock_acc.Write(mcbParam.dockAcc); // for the motion time model
         }
         break;
     case FULLRETRACT:
@@ -79,6 +88,7 @@ void StratoPIB::TCHandler(Telecommand_t telecommand)
         break;
     case CANCELMOTION:
         mcbComm.TX_ASCII(MCB_CANCEL_MOTION); // no matter what, attempt to send (irrespective of mode)
+        FlushCommandQueue("cancel motion");
         SetAction(ACTION_MOTION_STOP);
         SetAction(ACTION_OVERRIDE_TSEN);
         break;
@@ -122,6 +132,7 @@ void StratoPIB::TCHandler(Telecommand_t telecommand)
     case SETAUTO:
         if (!mcb_motion_ongoing) {
             autonomous_mode = true;
+            FlushCommandQueue("mode change");
             inst_substate = MODE_ENTRY; // restart FL in auto
             ZephyrLogFine("Set mode to auto");
         } else {
@@ -131,6 +142,7 @@ void StratoPIB::TCHandler(Telecommand_t telecommand)
     case SETMANUAL:
         if (!mcb_motion_ongoing) {
             autonomous_mode = false;
+            FlushCommandQueue("mode change");
             inst_substate = MODE_ENTRY; // restart FL in manual
             ZephyrLogFine("Set mode to manual");
         } else {
@@ -139,6 +151,7 @@ void StratoPIB::TCHandler(Telecommand_t telecommand)
         break;
     case SETSZAMIN:
         pibConfigs.sza_minimum.Write(pibParam.szaMinimum);
+        sza_predicted = 0; // predict again with the next check
         snprintf(log_array, LOG_ARRAY_SIZE, "Set sza_minimum: %f", pibConfigs.sza_minimum.Read());
         ZephyrLogFine(log_array);
         break;
@@ -200,13 +213,10 @@ void StratoPIB::TCHandler(Telecommand_t telecommand)
         }
         log_nominal("Received retry dock telecommand");
 
-        // schedule each action
-        SetAction(COMMAND_REDOCK);
-        SetAction(ACTION_OVERRIDE_TSEN);
-
-        // set the parameters
-        deploy_length = mcbParam.deployLen;
-        retract_length = mcbParam.retractLen;
+        command.type = QCMD_REDOCK;
+        command.deploy_length = mcbParam.deployLen;
+        command.retract_length = mcbParam.retractLen;
+        QueueCommand(command);
         break;
     case GETPUSTATUS:
         if (autonomous_mode) {
@@ -233,14 +243,13 @@ void StratoPIB::TCHandler(Telecommand_t telecommand)
         }
         log_nominal("Received manual profile telecommand");
 
-        pibConfigs.profile_size.Write(pibParam.profileSize);
-        pibConfigs.dock_amount.Write(pibParam.dockAmount);
-        pibConfigs.dock_overshoot.Write(pibParam.dockOvershoot);
-        pibConfigs.dwell_time.Write(pibParam.dwellTime);
-
-        // schedule each action
-        SetAction(COMMAND_MANUAL_PROFILE);
-        SetAction(ACTION_OVERRIDE_TSEN);
+        // the configs are written when the profile starts
+        command.type = QCMD_MANUAL_PROFILE;
+        command.profile_size = pibParam.profileSize;
+        command.dock_amount = pibParam.dockAmount;
+        command.dock_overshoot = pibParam.dockOvershoot;
+        command.seconds = pibParam.dwellTime;
+        QueueCommand(command);
         break;
     case OFFLOADPUPROFILE:
         if (autonomous_mode) {
@@ -250,8 +259,8 @@ void StratoPIB::TCHandler(Telecommand_t telecommand)
 
         log_nominal("Received offload PU profile TC");
 
-        SetAction(ACTION_OFFLOAD_PU);
-        SetAction(ACTION_OVERRIDE_TSEN);
+        command.type = QCMD_OFFLOAD_PU;
+        QueueCommand(command);
         break;
     case SETPREPROFILETIME:
         pibConfigs.preprofile_time.Write(pibParam.preprofileTime);
@@ -271,6 +280,100 @@ void StratoPIB::TCHandler(Telecommand_t telecommand)
                  pibConfigs.redock_in.Read(), pibConfigs.num_redock.Read());
         ZephyrLogFine(log_array);
         break;
+    case SETSZAPREDICT:
+        pibConfigs.sza_predict.Write(0 != pibParam.szaPredict);
+        sza_predicted = 0; // predict again with the next check
+        snprintf(log_array, LOG_ARRAY_SIZE, "Set sza_predict: %u", pibConfigs.sza_predict.Read());
+        ZephyrLogFine(log_array);
+        break;
+    case SETPARALLELRA:
+        pibConfigs.parallel_ra.Write(0 != pibParam.parallelRA);
+        snprintf(log_array, LOG_ARRAY_SIZE, "Set parallel_ra: %u", pibConfigs.parallel_ra.Read());
+        ZephyrLogFine(log_array);
+        break;
+    case SETCHARGEGATE:
+        pibConfigs.charge_gate.Write(0 != pibParam.chargeGate);
+        pibConfigs.pu_ready_voltage.Write(pibParam.puReadyVoltage);
+        pibConfigs.pu_min_voltage.Write(pibParam.puMinVoltage);
+        pibConfigs.pu_full_current.Write(pibParam.puFullCurrent);
+        pibConfigs.charge_max_wait.Write(pibParam.chargeMaxWait);
+        snprintf(log_array, LOG_ARRAY_SIZE, "Set charge gate: %u, %0.2f, %0.2f, %0.2f, %u", pibConfigs.charge_gate.Read(),
+                 pibConfigs.pu_ready_voltage.Read(), pibConfigs.pu_min_voltage.Read(), pibConfigs.pu_full_current.Read(),
+                 pibConfigs.charge_max_wait.Read());
+        ZephyrLogFine(log_array);
+        break;
+    case SETPLANENTRY:
+        plan_entry.type = pibParam.planType;
+        plan_entry.trigger = pibParam.planTrigger;
+        plan_entry.enables = pibParam.planEnables;
+        plan_entry.trigger_value = pibParam.planTriggerValue;
+        plan_entry.profile_size = pibParam.planProfileSize;
+        plan_entry.deploy_velocity = pibParam.planDeployVelocity;
+        plan_entry.retract_velocity = pibParam.planRetractVelocity;
+        plan_entry.dwell_time = pibParam.planDwellTime;
+        plan_entry.profile_rate = pibParam.planProfileRate;
+        plan_entry.dwell_rate = pibParam.planDwellRate;
+        SetPlanEntry(pibParam.planIndex, plan_entry); // sends result as log
+        break;
+    case CLEARPLAN:
+        ClearProfileTable();
+        ZephyrLogFine("Cleared profile plan");
+        break;
+    case SETPLANMODE:
+        pibConfigs.plan_mode.Write(0 != pibParam.planMode);
+        if (pibConfigs.plan_mode.Read()) {
+            // start from the first entry, and time PLAN_TRIGGER_AFTER from now
+            pibConfigs.plan_index.Write(0);
+            plan_last_end = (uint32_t) now();
+        }
+        snprintf(log_array, LOG_ARRAY_SIZE, "Set plan_mode: %u (%u entries)", pibConfigs.plan_mode.Read(), pibConfigs.profile_table.Read().count);
+        ZephyrLogFine(log_array);
+        break;
+    case GETPLAN:
+        if (mcb_motion_ongoing) {
+            ZephyrLogWarn("Motion ongoing, request profile plan later");
+        } else {
+            SendProfileTableTM();
+        }
+        break;
+    case SETDRUMGEOMETRY:
+        pibConfigs.drum_core_diameter.Write(pibParam.drumCoreDiameter);
+        pibConfigs.cable_diameter.Write(pibParam.cableDiameter);
+        pibConfigs.drum_width.Write(pibParam.drumWidth);
+        pibConfigs.docked_cable_length.Write(pibParam.dockedCableLength);
+        if (!ConfigureDrum()) {
+            ZephyrLogWarn("Invalid drum geometry, metre conversions disabled");
+            break;
+        }
+        snprintf(log_array, LOG_ARRAY_SIZE, "Set drum geometry: %0.4f, %0.4f, %0.4f, %0.1f", pibConfigs.drum_core_diameter.Read(),
+                 pibConfigs.cable_diameter.Read(), pibConfigs.drum_width.Read(), pibConfigs.docked_cable_length.Read());
+        ZephyrLogFine(log_array);
+        break;
+    case SETPROFILEMETRES:
+        if (SetProfileMetres(pibParam.profileDepth, pibParam.dockDepth, pibParam.dockOvershootMetres,
+                             pibParam.deploySpeed, pibParam.retractSpeed, pibParam.dockSpeed)) {
+            snprintf(log_array, LOG_ARRAY_SIZE, "Set profile revs: %0.2f, %0.2f, %0.2f at rpm: %0.1f, %0.1f, %0.1f",
+                     pibConfigs.profile_size.Read(), pibConfigs.dock_amount.Read(), pibConfigs.dock_overshoot.Read(),
+                     pibConfigs.deploy_velocity.Read(), pibConfigs.retract_velocity.Read(), pibConfigs.dock_velocity.Read());
+            ZephyrLogFine(log_array);
+        }
+        break;
+    case SETDOCKDETECT:
+        pibConfigs.dock_imon_threshold.Write(pibParam.dockImonThreshold);
+        pibConfigs.dock_tolerance.Write(pibParam.dockTolerance);
+        snprintf(log_array, LOG_ARRAY_SIZE, "Set dock detection: %u, %0.2f", pibConfigs.dock_imon_threshold.Read(), pibConfigs.dock_tolerance.Read());
+        ZephyrLogFine(log_array);
+        break;
+    case SETMOTIONANOMALY:
+        pibConfigs.torque_slope_limit.Write(pibParam.torqueSlopeLimit);
+        pibConfigs.current_slope_limit.Write(pibParam.currentSlopeLimit);
+        pibConfigs.temp_cusum_slack.Write(pibParam.tempCusumSlack);
+        pibConfigs.temp_cusum_limit.Write(pibParam.tempCusumLimit);
+        ConfigureMotionAnomaly();
+        snprintf(log_array, LOG_ARRAY_SIZE, "Set motion anomaly limits: %0.2f, %0.2f, %0.2f, %0.2f", pibConfigs.torque_slope_limit.Read(),
+                 pibConfigs.current_slope_limit.Read(), pibConfigs.temp_cusum_slack.Read(), pibConfigs.temp_cusum_limit.Read());
+        ZephyrLogFine(log_array);
+        break;
     case SETMOTIONTIMEOUT:
         pibConfigs.motion_timeout.Write(pibParam.motionTimeout);
         snprintf(log_array, LOG_ARRAY_SIZE, "Set motion_timeout: %u", pibConfigs.motion_timeout.Read());
@@ -283,6 +386,65 @@ void StratoPIB::TCHandler(Telecommand_t telecommand)
             SendPIBEEPROM();
         }
         break;
+    case GETPIBLOG:
+        if (mcb_motion_ongoing) {
+            ZephyrLogWarn("Motion ongoing, request PIB log later");
+        } else {
+            SendBinaryLogTM();
+        }
+        break;
+    case SETRETRIES:
+        pibConfigs.mcb_retries.Write(pibParam.mcbRetries);
+        pibConfigs.pu_retries.Write(pibParam.puRetries);
+        pibConfigs.zephyr_retries.Write(pibParam.zephyrRetries);
+        ConfigureRequests();
+        snprintf(log_array, LOG_ARRAY_SIZE, "Set retries (MCB, PU, Zephyr): %u, %u, %u", pibConfigs.mcb_retries.Read(),
+                 pibConfigs.pu_retries.Read(), pibConfigs.zephyr_retries.Read());
+        ZephyrLogFine(log_array);
+        break;
+    case SETRTOBOUNDS:
+        if (pibParam.rtoMin > pibParam.rtoMax) {
+            ZephyrLogWarn("Invalid RTO bounds, min exceeds max");
+            break;
+        }
+        if (TARGET_MCB == pibParam.rtoTarget) {
+            pibConfigs.mcb_rto_min.Write(pibParam.rtoMin);
+            pibConfigs.mcb_rto_max.Write(pibParam.rtoMax);
+        } else if (TARGET_PU == pibParam.rtoTarget) {
+            pibConfigs.pu_rto_min.Write(pibParam.rtoMin);
+            pibConfigs.pu_rto_max.Write(pibParam.rtoMax);
+        } else if (TARGET_ZEPHYR == pibParam.rtoTarget) {
+            pibConfigs.zephyr_rto_min.Write(pibParam.rtoMin);
+            pibConfigs.zephyr_rto_max.Write(pibParam.rtoMax);
+        } else {
+            ZephyrLogWarn("Invalid RTO target");
+            break;
+        }
+        ConfigureRequests();
+        snprintf(log_array, LOG_ARRAY_SIZE, "Set RTO bounds for target %u: %u - %u s", pibParam.rtoTarget, pibParam.rtoMin, pibParam.rtoMax);
+        ZephyrLogFine(log_array);
+        break;
+    case GETREQUESTSTATS:
+        if (mcb_motion_ongoing) {
+            ZephyrLogWarn("Motion ongoing, request stats later");
+        } else {
+            SendRequestStatsTM();
+        }
+        break;
+    case GETCMDQUEUE:
+        if (mcb_motion_ongoing) {
+            ZephyrLogWarn("Motion ongoing, request command queue later");
+        } else {
+            SendCommandQueueTM();
+        }
+        break;
+    case GETTRACE:
+        if (mcb_motion_ongoing) {
+            ZephyrLogWarn("Motion ongoing, request transition trace later");
+        } else {
+            SendTraceTM();
+        }
+        break;
     case DOCKEDPROFILE:
         if (autonomous_mode) {
             ZephyrLogWarn("Switch to manual mode before commanding docked profile");
@@ -290,12 +452,9 @@ void StratoPIB::TCHandler(Telecommand_t telecommand)
         }
         log_nominal("Received docked profile telecommand");
 
-        // set the duration
-        docked_profile_time = pibParam.dockedProfileTime;
-
-        // schedule each action
-        SetAction(COMMAND_DOCKED_PROFILE);
-        SetAction(ACTION_OVERRIDE_TSEN);
+        command.type = QCMD_DOCKED_PROFILE;
+        command.seconds = pibParam.dockedProfileTime;
+        QueueCommand(command);
         break;
     case STARTREALTIMEMCB:
         if (mcb_motion_ongoing) {
@@ -313,6 +472,61 @@ void StratoPIB::TCHandler(Telecommand_t telecommand)
             ZephyrLogFine("Exited real-time MCB mode");
         }
         break;
+    case SETMCBCOMPRESS:
+        if (mcb_motion_ongoing) {
+            ZephyrLogWarn("Cannot change MCB TM compression, motion ongoing");
+        } else {
+            pibConfigs.compress_mcb_tm.Write(0 != pibParam.mcbCompress);
+            snprintf(log_array, LOG_ARRAY_SIZE, "Set MCB TM compression: %u", pibConfigs.compress_mcb_tm.Read());
+            ZephyrLogFine(log_array);
+        }
+        break;
+    case SETRTMCB:
+        if (mcb_motion_ongoing) {
+            ZephyrLogWarn("Cannot change real-time MCB TM, motion ongoing");
+        } else {
+            pibConfigs.rt_frames.Write((0 == pibParam.rtFrames) ? 1 : pibParam.rtFrames);
+            pibConfigs.rt_period.Write(pibParam.rtPeriod);
+            pibConfigs.rt_decimate.Write(0 != pibParam.rtDecimate);
+            pibConfigs.rt_budget.Write(pibParam.rtBudget);
+            snprintf(log_array, LOG_ARRAY_SIZE, "Set real-time MCB TM: %u frames, %u s, decimate %u, %u B/min", pibConfigs.rt_frames.Read(),
+                     pibConfigs.rt_period.Read(), pibConfigs.rt_decimate.Read(), pibConfigs.rt_budget.Read());
+            ZephyrLogFine(log_array);
+        }
+        break;
+    case SETPUCOMPRESS:
+        pibConfigs.compress_pu.Write(0 != pibParam.puCompress);
+        pibConfigs.pu_delta_stride.Write(pibParam.puDeltaStride);
+        snprintf(log_array, LOG_ARRAY_SIZE, "Set PU record compression: %u, stride %u", pibConfigs.compress_pu.Read(), pibConfigs.pu_delta_stride.Read());
+        ZephyrLogFine(log_array);
+        break;
+    case RETRANSMITPU:
+        if (pibParam.archiveLast < pibParam.archiveFirst) {
+            ZephyrLogWarn("Invalid archive packet range");
+            break;
+        }
+
+        if (pibParam.archiveLast - pibParam.archiveFirst >= PU_ARCHIVE_RANGE) {
+            snprintf(log_array, LOG_ARRAY_SIZE, "Archive packet range too long, at most %u packets per request", PU_ARCHIVE_RANGE);
+            ZephyrLogWarn(log_array);
+            break;
+        }
+
+        if (!autonomous_mode) {
+            command.type = QCMD_RETRANSMIT;
+            command.night = pibParam.archiveNight;
+            command.profile = pibParam.archiveProfile;
+            command.first_packet = pibParam.archiveFirst;
+            command.last_packet = pibParam.archiveLast;
+            QueueCommand(command);
+        } else if (retransmit_machine.active || retransmit_machine.pending) {
+            ZephyrLogWarn("Retransmit already running, request again when finished");
+        } else {
+            // runs from the autonomous idle or profile wait, held until one is reached
+            StartRetransmit(pibParam.archiveNight, pibParam.archiveProfile, pibParam.archiveFirst, pibParam.archiveLast);
+            retransmit_machine.pending = true;
+        }
+        break;
 
     // PU Telecommands ------------------------------------
     case PUWARMUPCONFIGS:
@@ -0,0 +1,62 @@
+/*
+ *  TransitionTrace.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  A RAM ring buffer of timestamped state transitions
+ */
+
+#include "TransitionTrace.h"
+#include "PIBStateMachine.h"
+#include "Arduino.h"
+
+TransitionTrace * TransitionTrace::attached = NULL;
+
+static_assert(SM_MAX_IDS <= (TRACE_SOURCE_MODE >> 4), "state machine ids must fit below the other trace sources");
+
+void TransitionTrace::AttachToStateMachines()
+{
+    attached = this;
+    StateMachine::SetTraceHook(MachineHook);
+}
+
+void TransitionTrace::MachineHook(uint8_t machine_id, uint8_t instance, uint8_t state, uint8_t event, uint8_t next)
+{
+    if (NULL == attached) return;
+
+    // instances past the nibble share the last one rather than alias the first
+    if (instance >= TRACE_MAX_INSTANCES) instance = TRACE_MAX_INSTANCES - 1;
+
+    attached->Record((uint8_t) ((machine_id << 4) | instance), state, next, event);
+}
+
+void TransitionTrace::Record(uint8_t source, uint8_t from, uint8_t to, uint8_t cause)
+{
+    ring[head].millis = millis();
+    ring[head].source = source;
+    ring[head].from = from;
+    ring[head].to = to;
+    ring[head].cause = cause;
+
+    // overwrite the oldest entry when full
+    head = (head + 1) % TRACE_SIZE;
+    if (count < TRACE_SIZE) count++;
+    total++;
+}
+
+uint8_t TransitionTrace::Read(uint16_t index, uint8_t * buffer)
+{
+    if (index >= count) return 0;
+
+    const TraceEntry_t & entry = ring[(head + TRACE_SIZE - count + index) % TRACE_SIZE];
+
+    for (int i = 0; i < 4; i++) {
+        buffer[i] = (uint8_t) (entry.millis >> (8 * i));
+    }
+    buffer[4] = entry.source;
+    buffer[5] = entry.from;
+    buffer[6] = entry.to;
+    buffer[7] = entry.cause;
+
+    return TRACE_ENTRY_SIZE;
+}
@@ -0,0 +1,76 @@
+/*
+ *  TransitionTrace.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  A RAM ring buffer of timestamped state transitions for post-mortem timing
+ *  analysis. Every inst_mode and inst_substate change, every Flight_* state
+ *  machine transition, and every received telecommand is recorded. Unlike the
+ *  binary log, the trace isn't cleared when it is sent, so it can be
+ *  requested again after a failed profile.
+ *
+ *  Entry format (little-endian, 8 bytes):
+ *    [millis (4)][source (1)][from (1)][to (1)][cause (1)]
+ *
+ *  Sources below TRACE_SOURCE_MODE are Flight_* state machines, encoded as
+ *  (machine id << 4) | instance, with the event as the cause. Instances are
+ *  numbered per machine id, so each id has room for TRACE_MAX_INSTANCES. The
+ *  mode and substate sources have the last consumed action flag (or
+ *  TRACE_NO_CAUSE) as the cause, and telecommand entries store the
+ *  telecommand in the "to" field.
+ */
+
+#ifndef TRANSITIONTRACE_H
+#define TRANSITIONTRACE_H
+
+#include <stdint.h>
+
+#define TRACE_SIZE          256 // entries
+#define TRACE_ENTRY_SIZE    8   // bytes
+
+// sources that aren't Flight_* state machines
+#define TRACE_SOURCE_MODE           0xF0
+#define TRACE_SOURCE_SUBSTATE       0xF1
+#define TRACE_SOURCE_TELECOMMAND    0xF2
+
+#define TRACE_NO_CAUSE  0xFF
+
+#define TRACE_MAX_INSTANCES 16 // per machine id, the low nibble of the source
+
+struct TraceEntry_t {
+    uint32_t millis;
+    uint8_t source;
+    uint8_t from;
+    uint8_t to;
+    uint8_t cause;
+};
+
+class TransitionTrace {
+public:
+    TransitionTrace() { };
+    ~TransitionTrace() { };
+
+    // record every Flight_* state machine transition in this trace
+    void AttachToStateMachines();
+
+    void Record(uint8_t source, uint8_t from, uint8_t to, uint8_t cause);
+
+    // serialize the index-th oldest entry, returns the number of bytes written (0 if none)
+    uint8_t Read(uint16_t index, uint8_t * buffer);
+
+    uint16_t Count() { return count; }
+
+    // entries recorded since boot, including overwritten ones
+    uint32_t Total() { return total; }
+
+private:
+    static void MachineHook(uint8_t machine_id, uint8_t instance, uint8_t state, uint8_t event, uint8_t next);
+    static TransitionTrace * attached;
+
+    TraceEntry_t ring[TRACE_SIZE] = {{0}};
+    uint16_t head = 0;  // index of the next entry to write
+    uint16_t count = 0; // entries currently stored
+    uint32_t total = 0;
+};
+
+#endif /* TRANSITIONTRACE_H */
@@ -0,0 +1,33 @@
+/*
+ *  TestCheck.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Minimal checks for the host tests of the PIB's hardware-independent
+ *  classes. Each test program returns TestResult() from main, which is
+ *  non-zero if any check failed.
+ */
+
+#ifndef TESTCHECK_H
+#define TESTCHECK_H
+
+#include <stdio.h>
+
+static int test_checks = 0;
+static int test_failures = 0;
+
+#define CHECK(condition) do { \
+        test_checks++; \
+        if (!(condition)) { \
+            test_failures++; \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        } \
+    } while (0)
+
+static int TestResult(const char * name)
+{
+    printf("%s: %d checks, %d failed\n", name, test_checks, test_failures);
+    return (0 == test_failures) ? 0 : 1;
+}
+
+#endif /* TESTCHECK_H */
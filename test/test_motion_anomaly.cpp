@@ -0,0 +1,183 @@
+/*
+ *  test_motion_anomaly.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Feeds MCB motion TM frames through MotionAnomaly and checks that it trips
+ *  on rising torque, current, and temperature, and not on nominal motions or
+ *  with the checks disabled.
+ */
+
+#include "MotionAnomaly.h"
+#include "MotionTM.h"
+#include "TestCheck.h"
+#include <string.h>
+
+#define FRAME_SIZE      MOTION_TM_FRAME_SIZE
+#define FRAME_PERIOD    500 // ms
+
+struct Frame_t {
+    float current;
+    float torque;
+    float temp;
+};
+
+// a motion TM frame: status byte, then little-endian floats at the MotionTM.h offsets
+static void BuildFrame(const Frame_t & values, uint8_t * frame)
+{
+    memset(frame, 0, FRAME_SIZE);
+    memcpy(frame + MOTION_TM_CURRENT_INDEX, &values.current, sizeof(float));
+    memcpy(frame + MOTION_TM_TORQUE_INDEX, &values.torque, sizeof(float));
+    memcpy(frame + MOTION_TM_TEMP_INDEX, &values.temp, sizeof(float));
+}
+
+// decode the frame as StratoPIB::AnalyzeMotionTM does and add it, returns the frame's result
+static MotionAnomaly_t AddFrame(MotionAnomaly & anomaly, uint32_t time_ms, const Frame_t & values)
+{
+    uint8_t frame[FRAME_SIZE];
+    Frame_t decoded;
+
+    BuildFrame(values, frame);
+    memcpy(&decoded.current, frame + MOTION_TM_CURRENT_INDEX, sizeof(float));
+    memcpy(&decoded.torque, frame + MOTION_TM_TORQUE_INDEX, sizeof(float));
+    memcpy(&decoded.temp, frame + MOTION_TM_TEMP_INDEX, sizeof(float));
+
+    return anomaly.Add(time_ms, decoded.current, decoded.torque, decoded.temp);
+}
+
+// run frames for seconds from the generator, returns the time (ms) of the trip or 0
+template <typename Generator>
+static uint32_t RunMotion(MotionAnomaly & anomaly, uint32_t seconds, Generator generate)
+{
+    for (uint32_t t = 0; t <= 1000 * seconds; t += FRAME_PERIOD) {
+        if (ANOMALY_NONE != AddFrame(anomaly, 10000 + t, generate(t / 1000.0f))) return t;
+    }
+
+    return 0;
+}
+
+static AnomalyLimits_t Limits(float torque_slope, float current_slope, float temp_slack, float temp_cusum)
+{
+    AnomalyLimits_t limits = {torque_slope, current_slope, temp_slack, temp_cusum};
+    return limits;
+}
+
+static void TestNominal()
+{
+    MotionAnomaly anomaly;
+
+    // flat torque and current with a little noise, and a temperature rise within the slack
+    anomaly.Configure(Limits(1.0f, 0.5f, 10.0f, 600.0f));
+    anomaly.Reset(true);
+    CHECK(0 == RunMotion(anomaly, 300, [](float t) {
+        Frame_t f = {2.0f + ((int) (t * 2) % 2) * 0.05f, 5.0f - ((int) (t * 2) % 3) * 0.1f, 30.0f + t / 60.0f};
+        return f;
+    }));
+    CHECK(ANOMALY_NONE == anomaly.Tripped());
+}
+
+static void TestTempCUSUM()
+{
+    MotionAnomaly anomaly;
+    uint32_t trip = 0;
+
+    // 20 deg C above the start with a 10 deg C slack accumulates 10 deg C * s per second
+    anomaly.Configure(Limits(0.0f, 0.0f, 10.0f, 600.0f));
+    anomaly.Reset(true);
+    trip = RunMotion(anomaly, 120, [](float t) {
+        Frame_t f = {2.0f, 5.0f, (t < 0.1f) ? 30.0f : 50.0f};
+        return f;
+    });
+    CHECK(trip > 59000 && trip <= 61000);
+    CHECK(ANOMALY_TEMP_CUSUM == anomaly.Tripped());
+    CHECK(anomaly.Value() > anomaly.Limit());
+    CHECK(600.0f == anomaly.Limit());
+
+    // stays tripped until the next motion, without reporting again
+    CHECK(ANOMALY_NONE == AddFrame(anomaly, 200000, {2.0f, 5.0f, 50.0f}));
+    CHECK(ANOMALY_TEMP_CUSUM == anomaly.Tripped());
+    anomaly.Reset(true);
+    CHECK(ANOMALY_NONE == anomaly.Tripped());
+
+    // a rise within the slack never accumulates
+    trip = RunMotion(anomaly, 600, [](float t) {
+        Frame_t f = {2.0f, 5.0f, (t < 0.1f) ? 30.0f : 39.0f};
+        return f;
+    });
+    CHECK(0 == trip);
+}
+
+static void TestSlopes()
+{
+    MotionAnomaly anomaly;
+    uint32_t trip = 0;
+
+    // torque rising at 2 per second against a limit of 1 trips once the window is full
+    anomaly.Configure(Limits(1.0f, 0.5f, 10.0f, 0.0f));
+    anomaly.Reset(true);
+    trip = RunMotion(anomaly, 60, [](float t) {
+        Frame_t f = {2.0f, 5.0f + 2.0f * t, 30.0f};
+        return f;
+    });
+    CHECK(FRAME_PERIOD * (ANOMALY_WINDOW - 1) == trip);
+    CHECK(ANOMALY_TORQUE_SLOPE == anomaly.Tripped());
+    CHECK(anomaly.Value() > 1.9f && anomaly.Value() < 2.1f);
+
+    // current rising at 1 A per second against a limit of 0.5
+    anomaly.Reset(true);
+    trip = RunMotion(anomaly, 60, [](float t) {
+        Frame_t f = {2.0f + t, 5.0f, 30.0f};
+        return f;
+    });
+    CHECK(0 != trip);
+    CHECK(ANOMALY_CURRENT_SLOPE == anomaly.Tripped());
+
+    // a torque rise that starts mid-motion
+    anomaly.Reset(true);
+    trip = RunMotion(anomaly, 60, [](float t) {
+        Frame_t f = {2.0f, (t < 20.0f) ? 5.0f : 5.0f + 3.0f * (t - 20.0f), 30.0f};
+        return f;
+    });
+    CHECK(trip > 20000 && trip < 25000);
+    CHECK(ANOMALY_TORQUE_SLOPE == anomaly.Tripped());
+
+    // docking ends on a torque limit, so the slopes are skipped
+    anomaly.Reset(false);
+    trip = RunMotion(anomaly, 60, [](float t) {
+        Frame_t f = {2.0f + t, 5.0f + 2.0f * t, 30.0f};
+        return f;
+    });
+    CHECK(0 == trip);
+
+    // falling torque isn't an anomaly
+    anomaly.Reset(true);
+    trip = RunMotion(anomaly, 60, [](float t) {
+        Frame_t f = {2.0f, 100.0f - 2.0f * t, 30.0f};
+        return f;
+    });
+    CHECK(0 == trip);
+}
+
+static void TestDefaultsDisabled()
+{
+    MotionAnomaly anomaly;
+
+    // the PIBConfigs defaults: every limit 0, so nothing trips however bad the motion
+    anomaly.Configure(Limits(0.0f, 0.0f, 10.0f, 0.0f));
+    anomaly.Reset(true);
+    CHECK(0 == RunMotion(anomaly, 600, [](float t) {
+        Frame_t f = {2.0f + t, 5.0f + 2.0f * t, 30.0f + t};
+        return f;
+    }));
+    CHECK(ANOMALY_NONE == anomaly.Tripped());
+}
+
+int main()
+{
+    TestNominal();
+    TestTempCUSUM();
+    TestSlopes();
+    TestDefaultsDisabled();
+
+    return TestResult("test_motion_anomaly");
+}
@@ -0,0 +1,174 @@
+/*
+ *  test_motion_codec.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Round trips MCB motion TM frames through MotionEncoder and MotionDecoder,
+ *  and compares the compressed size against the raw buffered TM frames
+ *  (sync, tenths of seconds, frame).
+ */
+
+#include "MotionCodec.h"
+#include "TestCheck.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RAW_FRAME_SIZE  (3 + MOTION_FRAME_SIZE)
+#define MAX_FRAMES      600
+
+// a motion TM frame: status byte, then little-endian floats in the MotionTM.h order
+static void BuildFrame(uint8_t status, const float * fields, uint8_t * frame)
+{
+    frame[MOTION_TM_STATUS_INDEX] = status;
+    memcpy(frame + MOTION_TM_FLOAT_INDEX, fields, NUM_MOTION_TM_FLOATS * sizeof(float));
+}
+
+static float Noise(float amplitude)
+{
+    return amplitude * ((rand() % 2001) - 1000) / 1000.0f;
+}
+
+// a reel out
+static void MotionFrame(int i, uint8_t * frame)
+{
+    float t = i * 0.5f;
+    float fields[NUM_MOTION_TM_FLOATS] = {0};
+
+    fields[MOTION_TM_TORQUE] = 5.0f + Noise(0.2f);
+    fields[MOTION_TM_CURRENT] = 2.0f + Noise(0.05f);
+    fields[MOTION_TM_TEMP] = 30.0f + t / 120.0f;
+    fields[MOTION_TM_SPEED] = (t < 5.0f) ? 50.0f * t : 250.0f + Noise(1.0f);
+    fields[MOTION_TM_REEL_POSITION] = (t < 5.0f) ? 2.08f * t * t : 52.0f + 4.17f * (t - 5.0f);
+
+    BuildFrame(0x01, fields, frame);
+}
+
+// random bytes, as a worst case
+static void RandomFrame(int, uint8_t * frame)
+{
+    for (int i = 0; i < MOTION_FRAME_SIZE; i++) {
+        frame[i] = (uint8_t) rand();
+    }
+}
+
+// fields that change sign and include special values
+static void EdgeFrame(int i, uint8_t * frame)
+{
+    float fields[NUM_MOTION_TM_FLOATS] = {
+        (i % 2) ? -1.0f : 1.0f,
+        (float) -i,
+        (i % 7) ? 0.0f : -0.0f,
+        (i % 5) ? 1.0e30f : INFINITY,
+        (i % 11) ? (float) i : NAN,
+        1.0e-40f * i, // denormals
+    };
+
+    BuildFrame((uint8_t) i, fields, frame);
+}
+
+// Encode frames into segments of segment_frames (restarting on a keyframe), decode them
+// back, and check that they match. Returns the compressed size, or 0 on a mismatch.
+template <typename Generator>
+static uint32_t RoundTrip(int num_frames, int segment_frames, Generator generate)
+{
+    static uint8_t frames[MAX_FRAMES][MOTION_FRAME_SIZE];
+    static uint16_t times[MAX_FRAMES];
+    static uint8_t stream[MAX_FRAMES * MOTION_RECORD_MAX];
+    uint8_t frame[MOTION_FRAME_SIZE];
+    uint16_t tenths = 0;
+    uint32_t length = 0;
+    uint32_t offset = 0;
+    uint16_t consumed = 0;
+    MotionEncoder encoder;
+    MotionDecoder decoder;
+    bool match = true;
+
+    for (int i = 0; i < num_frames; i++) {
+        generate(i, frames[i]);
+        times[i] = (uint16_t) (i * 5 + rand() % 2);
+        if (0 == i % segment_frames) encoder.Reset();
+
+        uint8_t size = encoder.Encode(frames[i], times[i], stream + length, MOTION_RECORD_MAX);
+        CHECK(0 != size && size <= MOTION_RECORD_MAX);
+        if (0 == size) return 0;
+        length += size;
+    }
+
+    for (int i = 0; i < num_frames; i++) {
+        if (0 == i % segment_frames) decoder.Reset();
+
+        consumed = decoder.Decode(stream + offset, (uint16_t) (length - offset), frame, &tenths);
+        CHECK(0 != consumed);
+        if (0 == consumed) return 0;
+        offset += consumed;
+
+        match &= (0 == memcmp(frame, frames[i], MOTION_FRAME_SIZE)) && tenths == times[i];
+    }
+
+    CHECK(match);
+    CHECK(offset == length);
+
+    return match ? length : 0;
+}
+
+static void TestRoundTrips()
+{
+    uint32_t raw = MAX_FRAMES * RAW_FRAME_SIZE;
+    uint32_t motion = RoundTrip(MAX_FRAMES, 285, MotionFrame); // about MCB_TM_SEGMENT_SIZE of raw frames
+    uint32_t keyframes = RoundTrip(MAX_FRAMES, 1, MotionFrame);
+    uint32_t random_frames = RoundTrip(MAX_FRAMES, 285, RandomFrame);
+    uint32_t edge = RoundTrip(200, 50, EdgeFrame);
+
+    printf("motion frames: %u raw, %u compressed (%.2fx)\n", raw, motion, (double) raw / motion);
+    printf("keyframes only: %u, random frames: %u, edge cases: %u\n", keyframes, random_frames, edge);
+
+    // a typical motion compresses, and the worst case stays bounded
+    CHECK(0 != motion && motion < raw * 2 / 3);
+    CHECK(0 != keyframes && keyframes == raw);
+    CHECK(0 != random_frames && random_frames <= MAX_FRAMES * MOTION_RECORD_MAX);
+    CHECK(0 != edge);
+}
+
+static void TestBadInput()
+{
+    uint8_t frame[MOTION_FRAME_SIZE] = {0};
+    uint8_t stream[2 * MOTION_RECORD_MAX] = {0};
+    uint8_t out[MOTION_FRAME_SIZE] = {0};
+    uint16_t tenths = 0;
+    uint8_t key = 0;
+    uint8_t delta = 0;
+    MotionEncoder encoder;
+    MotionDecoder decoder;
+
+    // too small an output buffer
+    CHECK(0 == encoder.Encode(frame, 0, stream, 3));
+
+    encoder.Reset();
+    MotionFrame(0, frame);
+    key = encoder.Encode(frame, 0, stream, MOTION_RECORD_MAX);
+    MotionFrame(1, frame);
+    delta = encoder.Encode(frame, 5, stream + key, MOTION_RECORD_MAX);
+    CHECK(MOTION_KEYFRAME_SYNC == stream[0] && MOTION_DELTA_SYNC == stream[key]);
+
+    // a delta frame without its keyframe, truncated records, and an unknown sync byte
+    decoder.Reset();
+    CHECK(0 == decoder.Decode(stream + key, delta, out, &tenths));
+    decoder.Reset();
+    CHECK(0 == decoder.Decode(stream, key - 1, out, &tenths));
+    CHECK(key == decoder.Decode(stream, key, out, &tenths));
+    CHECK(0 == decoder.Decode(stream + key, 1, out, &tenths));
+    stream[0] = 0xA5;
+    decoder.Reset();
+    CHECK(0 == decoder.Decode(stream, key, out, &tenths));
+}
+
+int main()
+{
+    srand(1);
+
+    TestRoundTrips();
+    TestBadInput();
+
+    return TestResult("test_motion_codec");
+}
@@ -0,0 +1,140 @@
+/*
+ *  test_pu_compress.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2020
+ *
+ *  Round trips PU records through PURecordCompressor and DecompressPURecord
+ *  with and without the delta, and checks that malformed input is rejected.
+ */
+
+#include "PUCompress.h"
+#include "TestCheck.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_RECORD  8192 // PU_BUFFER_SIZE
+
+static uint8_t record[MAX_RECORD];
+static uint8_t compressed[PU_COMPRESS_BOUND(MAX_RECORD)];
+static uint8_t decompressed[MAX_RECORD];
+static PURecordCompressor compressor;
+
+// a profile record: a small header, then samples of slowly varying u16 and float fields
+static uint16_t ProfileRecord(uint8_t * buffer, uint16_t samples)
+{
+    uint16_t length = 0;
+
+    memcpy(buffer, "PROF", 4);
+    length = 4;
+
+    for (uint16_t i = 0; i < samples && length + 12 <= MAX_RECORD; i++) {
+        uint16_t pressure = (uint16_t) (10000 - 3 * i + rand() % 3);
+        uint16_t counts = (uint16_t) (200 + rand() % 8);
+        float temp = -60.0f + i * 0.01f;
+        uint32_t time = 1600000000u + i;
+
+        memcpy(buffer + length, &pressure, 2);
+        memcpy(buffer + length + 2, &counts, 2);
+        memcpy(buffer + length + 4, &temp, 4);
+        memcpy(buffer + length + 8, &time, 4);
+        length += 12;
+    }
+
+    return length;
+}
+
+// compress and decompress, returns the compressed size, or 0 if the round trip fails
+static uint16_t RoundTrip(uint16_t length, uint8_t stride)
+{
+    uint16_t size = compressor.Compress(record, length, stride, compressed, sizeof(compressed));
+    uint16_t restored = 0;
+
+    CHECK(0 != size && size <= PU_COMPRESS_BOUND(length));
+    if (0 == size) return 0;
+
+    CHECK(PU_COMPRESS_MAGIC == compressed[0]);
+
+    memset(decompressed, 0, sizeof(decompressed));
+    restored = DecompressPURecord(compressed, size, decompressed, sizeof(decompressed));
+    CHECK(length == restored);
+    CHECK(0 == memcmp(record, decompressed, length));
+
+    return (length == restored && 0 == memcmp(record, decompressed, length)) ? size : 0;
+}
+
+static void TestProfileRecords()
+{
+    uint16_t length = ProfileRecord(record, 600);
+    uint16_t plain = RoundTrip(length, 0);
+    uint16_t delta = RoundTrip(length, 12);
+
+    printf("profile record: %u bytes, %u LZ, %u delta + LZ\n", length, plain, delta);
+
+    // the noisy low bytes defeat plain LZ, the delta is what makes samples compress
+    CHECK(0 != plain && plain <= PU_COMPRESS_BOUND(length));
+    CHECK(0 != delta && delta < length / 2 && delta < plain);
+}
+
+static void TestEdgeCases()
+{
+    // empty, single byte, and constant records
+    CHECK(0 != RoundTrip(0, 0));
+    record[0] = 0x5A;
+    CHECK(0 != RoundTrip(1, 0));
+    memset(record, 0xAB, MAX_RECORD);
+    CHECK(RoundTrip(MAX_RECORD, 0) < MAX_RECORD / 20);
+    CHECK(0 != RoundTrip(MAX_RECORD, 255));
+
+    // random bytes don't shrink, and are stored with only the header
+    for (int i = 0; i < MAX_RECORD; i++) record[i] = (uint8_t) rand();
+    CHECK(PU_COMPRESS_BOUND(MAX_RECORD) == RoundTrip(MAX_RECORD, 0));
+    CHECK(PU_COMPRESS_STORED == compressed[1]);
+
+    // random lengths, strides, and mixes of runs and noise
+    for (int trial = 0; trial < 500; trial++) {
+        uint16_t length = (uint16_t) (rand() % MAX_RECORD);
+        uint8_t stride = (uint8_t) ((rand() % 4) ? rand() % 33 : rand() % 256);
+
+        for (uint16_t i = 0; i < length; i++) {
+            record[i] = (rand() % 4) ? (uint8_t) (i / (1 + rand() % 16)) : (uint8_t) rand();
+        }
+        CHECK(0 != RoundTrip(length, stride));
+    }
+}
+
+static void TestBadInput()
+{
+    uint16_t length = ProfileRecord(record, 100);
+    uint16_t size = compressor.Compress(record, length, 12, compressed, sizeof(compressed));
+
+    // too small an output buffer to compress into or decompress into
+    CHECK(0 == compressor.Compress(record, length, 12, compressed, PU_COMPRESS_BOUND(length) - 1));
+    CHECK(0 == DecompressPURecord(compressed, size, decompressed, length - 1));
+
+    // truncated, a bad magic byte, and an unknown method
+    CHECK(0 == DecompressPURecord(compressed, size - 1, decompressed, sizeof(decompressed)));
+    CHECK(0 == DecompressPURecord(compressed, PU_COMPRESS_HEADER - 1, decompressed, sizeof(decompressed)));
+    compressed[0] ^= 0xFF;
+    CHECK(0 == DecompressPURecord(compressed, size, decompressed, sizeof(decompressed)));
+    compressed[0] ^= 0xFF;
+    compressed[1] = 7;
+    CHECK(0 == DecompressPURecord(compressed, size, decompressed, sizeof(decompressed)));
+
+    // random corruption must never overrun the output (checked under the sanitizers)
+    for (int trial = 0; trial < 2000; trial++) {
+        size = compressor.Compress(record, length, 12, compressed, sizeof(compressed));
+        compressed[PU_COMPRESS_HEADER + rand() % (size - PU_COMPRESS_HEADER)] = (uint8_t) rand();
+        DecompressPURecord(compressed, size, decompressed, sizeof(decompressed));
+    }
+}
+
+int main()
+{
+    srand(1);
+
+    TestProfileRecords();
+    TestEdgeCases();
+    TestBadInput();
+
+    return TestResult("test_pu_compress");
+}